@@ -7,14 +7,22 @@
 //! @details
 //!             This class implements thread-unsafe lightweight linked list
 #pragma once
+#include <functional>
 #include <iterator>
 #include <new>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <type_traits>
 #include <utility>
+#include "../uEmbedded/bitops.h"
 #include "../uEmbedded/uassert.h"
 
+namespace upp {
+template <typename dty_, typename nty_, bool chunked_>
+class shared_fslist;
+}
+
 namespace upp { namespace impl {
 //! @addtogroup uEmbedded_Cpp
 //! @{
@@ -67,6 +75,15 @@ private:
     friend class fslist_alloc_base;
 };
 
+//! @brief      Head, tail and size of single list in the node pool.
+template <typename nty_>
+struct fslist_links
+{
+    nty_ head_;
+    nty_ tail_;
+    nty_ size_;
+};
+
 //! @brief
 //!             Base class of fslist that manages fslist nodes based on size
 //!             type template argument
@@ -80,12 +97,9 @@ private:
 //!             through class instances.
 //! @tparam     nty_ \ref upp::impl::fslist_node
 //!
-//! @todo       Provide functionality for dynamic capacity features.
-//!              Due to the nature of the free space list, it is difficult to
-//!             implement a shrink operation for memory copy, so shrinkand
-//!             extend are implemented by connecting the active node to the new
-//!             node buffer from the front.
-//! @todo       Implement heap based fslist
+//!              Capacity can be changed by derived class through set_nodes(),
+//!             e.g. @ref upp::dynamic_fslist. Since nodes refer to each other
+//!             by index, the node array can be relocated freely.
 template <typename nty_>
 class fslist_alloc_base
 {
@@ -93,100 +107,323 @@ protected:
     using size_type       = nty_;
     using difference_type = ptrdiff_t;
     using node_type       = fslist_node<size_type>;
+    using links_type      = fslist_links<size_type>;
     enum
     {
         NODE_NONE = (size_type)-1
     };
 
+    //! @brief      Called when a node is allocated from full pool. It may
+    //!             extend capacity with set_nodes().
+    using grow_fn_type = void ( * )( fslist_alloc_base* ) noexcept;
+
     //! @brief      Constructor of node management class
+    //! @details
+    //!              O(1). Node array is not touched until nodes are allocated;
+    //!             never used nodes are taken from high-water mark, and only
+    //!             released nodes are linked into idle list.
     //! @param      capacity Given node array's capacity.
     //! @param      narray Provided node array
-    fslist_alloc_base( size_type capacity, node_type* narray ) noexcept
-        : size_( 0 )
+    //! @param      live Occupancy bitmap of live_words_of( capacity ) words.
+    //!             Needs no initialization; words are cleared as high-water
+    //!             mark enters them.
+    constexpr fslist_alloc_base(
+      size_type  capacity,
+      node_type* narray,
+      uint64_t*  live ) noexcept
+        : list_ { NODE_NONE, NODE_NONE, 0 }
+        , used_( 0 )
         , capacity_( capacity )
-        , head_( NODE_NONE )
-        , tail_( NODE_NONE )
-        , idle_front_( 0 )
-        , idle_back_( capacity - 1 )
+        , idle_front_( NODE_NONE )
+        , idle_back_( NODE_NONE )
+        , hwm_( 0 )
         , narray_( narray )
+        , live_( live )
+        , grow_( nullptr )
+    {
+    }
+
+    //! @brief      Number of bitmap words required for given capacity.
+    static constexpr size_t live_words_of( size_t capacity ) noexcept
+    {
+        return ( capacity + 63 ) / 64;
+    }
+
+    //! @brief      Replace node array and extend capacity.
+    //! @details
+    //!              Active and released nodes must be already copied into new
+    //!             array, and bitmap must have been replaced by set_live() to
+    //!             cover new capacity.
+    void set_nodes( node_type* narray, size_type capacity ) noexcept
+    {
+        uassert( capacity >= capacity_ );
+        narray_   = narray;
+        capacity_ = capacity;
+    }
+
+    //! @brief      Replace occupancy bitmap. Words below high-water mark must
+    //!             be already copied into it.
+    void      set_live( uint64_t* live ) noexcept { live_ = live; }
+    uint64_t* live() const noexcept { return live_; }
+
+    //! @brief      Reduce capacity. Nodes beyond new capacity must not be
+    //!             active; they are dropped from idle list here, after which
+    //!             node array can be shrunk.
+    void truncate_nodes( size_type capacity ) noexcept
     {
-        // Link all available nodes
-        for ( size_t i = 0; i < capacity; i++ ) {
-            auto p  = narray_ + i;
-            p->nxt_ = static_cast<size_type>( i + 1 );
-            p->cur_ = NODE_NONE;
-            p->prv_ = static_cast<size_type>( i - 1 );
+        uassert( live_end() <= capacity );
+        for ( size_type i = idle_front_; i != NODE_NONE; ) {
+            auto next = narray_[i].nxt_;
+            if ( i >= capacity )
+                unlink_idle_( i );
+            i = next;
         }
-        narray_[0].prv_             = NODE_NONE;
-        narray_[capacity_ - 1].nxt_ = NODE_NONE;
+
+        if ( hwm_ > capacity )
+            hwm_ = capacity;
+        capacity_ = capacity;
     }
 
-    //! @brief      Insert new node at given location
-    //! @param      i
-    //! @param      at
-    void insert_node( size_type i, size_type at ) noexcept
+    void       set_grow( grow_fn_type fn ) noexcept { grow_ = fn; }
+    node_type* nodes() const noexcept { return narray_; }
+
+    //! @brief      Get one past the last active node index.
+    size_type live_end() const noexcept
+    {
+        size_type e = hwm_;
+        while ( e && narray_[e - 1].cur_ == NODE_NONE )
+            --e;
+        return e;
+    }
+
+    //! @brief      Link node into given list, before node 'at'.
+    //! @param      at NODE_NONE to append.
+    void link_node( links_type& l, size_type i, size_type at ) noexcept
     {
         node_type& n = narray_[i];
-        if ( at == NODE_NONE ) { // Insert at last
-            push_back_node( i );
-        }
-        else if ( at == head_ ) {
-            push_front_node( i );
+        uassert( n.cur_ != NODE_NONE );
+
+        if ( at == NODE_NONE ) {
+            n.prv_ = l.tail_;
+            n.nxt_ = NODE_NONE;
+            if ( l.tail_ != NODE_NONE )
+                narray_[l.tail_].nxt_ = i;
+            else
+                l.head_ = i;
+            l.tail_ = i;
         }
         else {
             node_type& m = narray_[at];
-            uassert( n.cur_ != NODE_NONE );
             uassert( m.cur_ != NODE_NONE );
-            uassert( m.prv_ != NODE_NONE );
 
-            m.prev().nxt_ = i;
-            n.prv_        = m.prv_;
-            m.prv_        = i;
-            n.nxt_        = at;
+            n.prv_ = m.prv_;
+            n.nxt_ = at;
+            if ( m.prv_ != NODE_NONE )
+                narray_[m.prv_].nxt_ = i;
+            else
+                l.head_ = i;
+            m.prv_ = i;
         }
+        ++l.size_;
     }
 
-    //! @brief      Append new node to backward
-    void push_back_node( size_type i ) noexcept
+    //! @brief      Unlink node from given list. The node stays allocated.
+    void unlink_node( links_type& l, size_type i ) noexcept
     {
-        node_type& n = narray_[i];
+        auto& n = narray_[i];
         uassert( n.cur_ != NODE_NONE );
+        uassert( l.size_ );
 
-        if ( tail_ != NODE_NONE )
-            narray_[tail_].nxt_ = i;
-        else {
-            uassert( head_ == NODE_NONE );
-            head_ = i;
-        }
+        if ( n.nxt_ != NODE_NONE )
+            narray_[n.nxt_].prv_ = n.prv_;
+        else // It's tail
+            l.tail_ = n.prv_;
+
+        if ( n.prv_ != NODE_NONE )
+            narray_[n.prv_].nxt_ = n.nxt_;
+        else // It's head
+            l.head_ = n.nxt_;
 
-        n.prv_ = tail_;
-        tail_  = i;
+        --l.size_;
     }
 
-    //! @brief      Insert front-most node
-    void push_front_node( size_type i ) noexcept
+    //! @brief      Move nodes [first, last) of src before 'pos' of dst. O(1)
+    //! @param      count Number of nodes in the range.
+    //! @param      last NODE_NONE for the end of src.
+    void splice_nodes(
+      links_type& dst,
+      size_type   pos,
+      links_type& src,
+      size_type   first,
+      size_type   last,
+      size_type   count ) noexcept
     {
-        node_type& n = narray_[i];
-        uassert( n.cur_ != NODE_NONE );
+        if ( first == last )
+            return;
 
-        if ( head_ != NODE_NONE )
-            narray_[head_].prv_ = i;
-        else {
-            uassert( tail_ == NODE_NONE );
-            tail_ = i;
+        // Range already sits right before pos.
+        if ( &src == &dst && ( pos == first || pos == last ) )
+            return;
+
+        size_type back = last == NODE_NONE ? src.tail_ : narray_[last].prv_;
+        size_type front_prev = narray_[first].prv_;
+
+        // Detach from source
+        if ( front_prev != NODE_NONE )
+            narray_[front_prev].nxt_ = last;
+        else
+            src.head_ = last;
+        if ( last != NODE_NONE )
+            narray_[last].prv_ = front_prev;
+        else
+            src.tail_ = front_prev;
+        src.size_ -= count;
+
+        // Attach to destination
+        size_type before = pos == NODE_NONE ? dst.tail_ : narray_[pos].prv_;
+        narray_[first].prv_ = before;
+        narray_[back].nxt_  = pos;
+        if ( before != NODE_NONE )
+            narray_[before].nxt_ = first;
+        else
+            dst.head_ = first;
+        if ( pos != NODE_NONE )
+            narray_[pos].prv_ = back;
+        else
+            dst.tail_ = back;
+        dst.size_ += count;
+    }
+
+    //! @brief      Count nodes in range [first, last). O(n)
+    size_type count_nodes( size_type first, size_type last ) const noexcept
+    {
+        size_type n = 0;
+        for ( ; first != last; first = narray_[first].nxt_ )
+            ++n;
+        return n;
+    }
+
+    //! @brief      Merge sorted src into sorted dst. Stable; on tie, nodes of
+    //!             dst come first.
+    //! @param      less_ Compares two node indexes.
+    template <typename less_fn__>
+    void merge_nodes( links_type& dst, links_type& src, less_fn__&& less_ )
+    {
+        size_type i = dst.head_;
+        while ( src.head_ != NODE_NONE ) {
+            if ( i == NODE_NONE ) {
+                splice_nodes(
+                  dst, NODE_NONE, src, src.head_, NODE_NONE, src.size_ );
+                break;
+            }
+
+            size_type j = src.head_;
+            if ( less_( j, i ) )
+                splice_nodes( dst, i, src, j, narray_[j].nxt_, 1 );
+            else
+                i = narray_[i].nxt_;
         }
+    }
 
-        n.nxt_ = head_;
-        head_  = i;
+    //! @brief      Sort nodes of given list by relinking them. Stable,
+    //!             O(n log n) bottom-up merge sort without extra memory.
+    template <typename less_fn__>
+    void sort_nodes( links_type& l, less_fn__&& less_ )
+    {
+        if ( l.size_ < 2 )
+            return;
+
+        size_type list = l.head_;
+        for ( size_t width = 1;; width <<= 1 ) {
+            size_type p = list, tail = NODE_NONE;
+            size_t    num_merges = 0;
+            list                 = NODE_NONE;
+
+            while ( p != NODE_NONE ) {
+                ++num_merges;
+
+                size_type q      = p;
+                size_t    p_size = 0, q_size = width;
+                for ( ; p_size < width && q != NODE_NONE; ++p_size )
+                    q = narray_[q].nxt_;
+
+                while ( p_size || ( q_size && q != NODE_NONE ) ) {
+                    size_type e;
+                    if ( p_size == 0 || ( q_size && q != NODE_NONE
+                                          && less_( q, p ) ) ) {
+                        e = q, q = narray_[q].nxt_, --q_size;
+                    }
+                    else {
+                        e = p, p = narray_[p].nxt_, --p_size;
+                    }
+
+                    if ( tail != NODE_NONE )
+                        narray_[tail].nxt_ = e;
+                    else
+                        list = e;
+                    tail = e;
+                }
+                p = q;
+            }
+            narray_[tail].nxt_ = NODE_NONE;
+
+            if ( num_merges <= 1 )
+                break;
+        }
+
+        // Only forward links were maintained above.
+        size_type prev = NODE_NONE;
+        for ( size_type i = list; i != NODE_NONE; i = narray_[i].nxt_ ) {
+            narray_[i].prv_ = prev;
+            prev            = i;
+        }
+        l.head_ = list;
+        l.tail_ = prev;
+    }
+
+    //! @brief      Insert new node at given location of own list.
+    void insert_node( size_type i, size_type at ) noexcept
+    {
+        link_node( list_, i, at );
+    }
+
+    //! @brief      Append new node to backward
+    void push_back_node( size_type i ) noexcept
+    {
+        link_node( list_, i, NODE_NONE );
+    }
+
+    //! @brief      Insert front-most node
+    void push_front_node( size_type i ) noexcept
+    {
+        link_node( list_, i, list_.head_ );
     }
 
     //! @brief      Allocate new node from memory pool
     //! @details
-    //!              The node's links are returned unbroken, so the front and
-    //!             back links must be redirected.
+    //!              The node is not linked to any list yet.
+    //! @returns    NODE_NONE if the pool is full, and could not grow.
     size_type alloc_node() noexcept
     {
-        uassert( size_ < capacity_ );
+        if ( used_ == capacity_ && grow_ )
+            grow_( this );
+
+        if ( used_ == capacity_ )
+            return NODE_NONE;
+
+        ++used_;
+        if ( idle_front_ == NODE_NONE ) {
+            if ( hwm_ % 64 == 0 )
+                live_[hwm_ / 64] = 0;
+
+            auto& n = narray_[hwm_];
+            n.cur_  = hwm_++;
+            n.nxt_  = NODE_NONE;
+            n.prv_  = NODE_NONE;
+            set_live_( n.cur_ );
+            return n.cur_;
+        }
+
         auto& n     = narray_[idle_front_];
         n.cur_      = idle_front_;
         idle_front_ = n.nxt_;
@@ -196,31 +433,16 @@ protected:
             narray_[idle_front_].prv_ = NODE_NONE;
         n.nxt_ = NODE_NONE;
         n.prv_ = NODE_NONE;
-        ++size_;
+        set_live_( n.cur_ );
         return n.cur_;
     }
 
-    //! @brief      Unlink given node and put it back to memory pool.
-    //! @param      i Node index to unlink
-    void dealloc_node( size_type i ) noexcept
+    //! @brief      Put unlinked node back to memory pool.
+    void free_node( size_type i ) noexcept
     {
         auto& n = narray_[i];
         uassert( n.cur_ != NODE_NONE );
-        uassert( i >= 0 && i < capacity_ );
-
-        if ( n.nxt_ != NODE_NONE ) {
-            n.next().prv_ = n.prv_;
-        }
-        else { // It's tail
-            tail_ = n.prv_;
-        }
-
-        if ( n.prv_ != NODE_NONE ) {
-            n.prev().nxt_ = n.nxt_;
-        }
-        else { // It's head
-            head_ = n.nxt_;
-        }
+        uassert( i < capacity_ );
 
         if ( idle_back_ != NODE_NONE ) {
             narray_[idle_back_].nxt_ = i;
@@ -233,21 +455,129 @@ protected:
         n.nxt_     = NODE_NONE;
         n.cur_     = NODE_NONE;
         idle_back_ = i;
-        --size_;
+        --used_;
+        live_[i / 64] &= ~( uint64_t( 1 ) << ( i % 64 ) );
+    }
+
+    //! @brief      Unlink given node and put it back to memory pool.
+    //! @param      i Node index to unlink
+    void dealloc_node( size_type i ) noexcept
+    {
+        unlink_node( list_, i );
+        free_node( i );
     }
 
+    //! @brief      Reorder nodes so that n-th active node is at index n.
+    //! @details
+    //!              Node contents are relocated in list order. For each active
+    //!             node not yet in place, move_( from, to, swap ) is invoked
+    //!             before nodes are changed, where swap means the node at
+    //!             'to' is active, and must be exchanged with 'from' instead of
+    //!             being overwritten. Then moved_( origin, to ) is invoked
+    //!             once the element lands on its final index.
+    //!              Idle list is emptied, and high-water mark is set to size.
+    template <typename move_fn__, typename moved_fn__>
+    void compact_nodes( move_fn__&& move_, moved_fn__&& moved_ ) noexcept
+    {
+        // Nodes borrowed by shared lists can't be reordered.
+        uassert( used_ == list_.size_ );
+
+        // Prev link of an element not placed yet holds its original index.
+        // Prev link of a placed node holds where its former element went.
+        for ( size_type i = list_.head_; i != NODE_NONE; i = narray_[i].nxt_ )
+            narray_[i].prv_ = i;
+
+        size_type pos = 0;
+        size_type next;
+        for ( size_type i = list_.head_; i != NODE_NONE; ++pos, i = next ) {
+            while ( i < pos )
+                i = narray_[i].prv_;
+
+            auto& n      = narray_[i];
+            auto& m      = narray_[pos];
+            next         = n.nxt_;
+            auto  origin = n.prv_;
+
+            if ( i != pos ) {
+                bool swap = pos < hwm_ && m.cur_ != NODE_NONE;
+                move_( i, pos, swap );
+
+                if ( swap ) {
+                    std::swap( n, m );
+                    n.cur_ = i;
+                    m.prv_ = i;
+                }
+                else {
+                    m      = n;
+                    n.cur_ = NODE_NONE;
+                    m.prv_ = NODE_NONE;
+                }
+                m.cur_ = pos;
+            }
+            else {
+                m.prv_ = NODE_NONE;
+            }
+
+            if ( origin != pos )
+                moved_( origin, pos );
+        }
+
+        for ( size_type i = 0; i < list_.size_; ++i ) {
+            narray_[i].prv_ = static_cast<size_type>( i - 1 );
+            narray_[i].nxt_ = static_cast<size_type>( i + 1 );
+        }
+        for ( size_type i = list_.size_; i < hwm_; ++i )
+            narray_[i].cur_ = NODE_NONE;
+
+        if ( list_.size_ ) {
+            auto last = static_cast<size_type>( list_.size_ - 1 );
+
+            narray_[0].prv_    = NODE_NONE;
+            narray_[last].nxt_ = NODE_NONE;
+            list_.head_        = 0;
+            list_.tail_        = last;
+        }
+        idle_front_ = NODE_NONE;
+        idle_back_  = NODE_NONE;
+        hwm_        = list_.size_;
+
+        size_t w = 0;
+        for ( ; w < size_t( hwm_ ) / 64; ++w )
+            live_[w] = ~uint64_t( 0 );
+        if ( hwm_ % 64 )
+            live_[w] = ( uint64_t( 1 ) << ( hwm_ % 64 ) ) - 1;
+    }
+
+    //! @brief      Release every node at once, without unlinking them.
+    //! @returns    false if any node is borrowed by shared lists. Then nothing
+    //!             is done.
+    bool reset_nodes() noexcept
+    {
+        if ( used_ != list_.size_ )
+            return false;
+
+        list_       = { NODE_NONE, NODE_NONE, 0 };
+        used_       = 0;
+        idle_front_ = NODE_NONE;
+        idle_back_  = NODE_NONE;
+        hwm_        = 0;
+        return true;
+    }
+
+    links_type& links() noexcept { return list_; }
+
     //! @brief      Get front node index
-    size_type head() const noexcept { return head_; }
+    size_type head() const noexcept { return list_.head_; }
 
     //! @brief      Get last valid node index.
-    size_type tail() const noexcept { return tail_; }
+    size_type tail() const noexcept { return list_.tail_; }
 
     size_type next( size_type n ) const noexcept { return narray_[n].nxt_; }
     size_type prev( size_type n ) const noexcept { return narray_[n].prv_; }
 
     bool valid_node( size_type n ) const noexcept
     {
-        return n != NODE_NONE && narray_[n].cur_ != NODE_NONE;
+        return n < hwm_ && narray_[n].cur_ != NODE_NONE;
     }
 
 public:
@@ -255,26 +585,56 @@ public:
     size_type max_size() const noexcept { return capacity_; }
 
     //! @brief      Get number of currently activated nodes
-    size_type size() const noexcept { return size_; }
+    size_type size() const noexcept { return list_.size_; }
 
     //! @brief      Check if list is empty
-    bool empty() const noexcept { return size_ == 0; }
+    bool empty() const noexcept { return list_.size_ == 0; }
 
-    template <typename ty1_, typename ty_2>
+    //! @brief      Get number of nodes allocated from the pool, including the
+    //!             ones borrowed by shared lists.
+    size_type pool_size() const noexcept { return used_; }
+
+    //! @brief      Get number of bitmap words which may hold a live node.
+    size_t live_words() const noexcept { return live_words_of( hwm_ ); }
+
+    template <typename ty1_, typename ty2_, bool chunked_>
     friend class fslist_const_iterator;
 
 private:
-    size_type  size_;
-    size_type  capacity_;
-    size_type  head_;
-    size_type  tail_;
-    size_type  idle_front_;
-    size_type  idle_back_;
-    node_type* narray_;
+    void set_live_( size_type i ) noexcept
+    {
+        live_[i / 64] |= uint64_t( 1 ) << ( i % 64 );
+    }
+
+    void unlink_idle_( size_type i ) noexcept
+    {
+        auto& n = narray_[i];
+
+        if ( n.prv_ != NODE_NONE )
+            narray_[n.prv_].nxt_ = n.nxt_;
+        else
+            idle_front_ = n.nxt_;
+
+        if ( n.nxt_ != NODE_NONE )
+            narray_[n.nxt_].prv_ = n.prv_;
+        else
+            idle_back_ = n.prv_;
+    }
+
+private:
+    links_type   list_;
+    size_type    used_;
+    size_type    capacity_;
+    size_type    idle_front_;
+    size_type    idle_back_;
+    size_type    hwm_;
+    node_type*   narray_;
+    uint64_t*    live_;
+    grow_fn_type grow_;
 };
 
 //! @brief      list iterator definition
-template <typename dty_, typename nty_>
+template <typename dty_, typename nty_, bool chunked_ = false>
 class fslist_const_iterator
 {
 public:
@@ -290,18 +650,18 @@ public:
         NODE_NONE = (size_type)-1
     };
 
-    fslist_const_iterator<dty_, nty_>& operator++() noexcept;
-    fslist_const_iterator<dty_, nty_>  operator++( int ) noexcept;
-    fslist_const_iterator<dty_, nty_>& operator--() noexcept;
-    fslist_const_iterator<dty_, nty_>  operator--( int ) noexcept;
-    reference                          operator*() const noexcept;
-    pointer                            operator->() const noexcept;
+    fslist_const_iterator& operator++() noexcept;
+    fslist_const_iterator  operator++( int ) noexcept;
+    fslist_const_iterator& operator--() noexcept;
+    fslist_const_iterator  operator--( int ) noexcept;
+    reference              operator*() const noexcept;
+    pointer                operator->() const noexcept;
 
-    bool operator!=( const fslist_const_iterator<dty_, nty_>& r ) const noexcept
+    bool operator!=( const fslist_const_iterator& r ) const noexcept
     {
         return r.container_ != container_ || r.cur_ != cur_;
     }
-    bool operator==( const fslist_const_iterator<dty_, nty_>& r ) const noexcept
+    bool operator==( const fslist_const_iterator& r ) const noexcept
     {
         return r.container_ == container_ && r.cur_ == cur_;
     }
@@ -316,13 +676,13 @@ private:
     size_type             cur_;
 
 private:
-    template <typename ty1_, typename ty2_>
+    template <typename ty1_, typename ty2_, bool ty3_>
     friend class fslist_base;
 };
 
 //! @brief      Modifiable list iterator
-template <typename dty_, typename nty_>
-class fslist_iterator : public fslist_const_iterator<dty_, nty_>
+template <typename dty_, typename nty_, bool chunked_ = false>
+class fslist_iterator : public fslist_const_iterator<dty_, nty_, chunked_>
 {
 public:
     using iterator_category = std::bidirectional_iterator_tag;
@@ -332,23 +692,23 @@ public:
     using reference         = dty_&;
     using size_type         = nty_;
     using container_type    = fslist_alloc_base<nty_>;
-    using super             = fslist_const_iterator<dty_, nty_>;
+    using super             = fslist_const_iterator<dty_, nty_, chunked_>;
 
-    fslist_iterator<dty_, nty_>& operator++() noexcept
+    fslist_iterator& operator++() noexcept
     {
-        return static_cast<fslist_iterator<dty_, nty_>&>( super::operator++() );
+        return static_cast<fslist_iterator&>( super::operator++() );
     }
-    fslist_iterator<dty_, nty_> operator++( int ) noexcept
+    fslist_iterator operator++( int ) noexcept
     {
         auto r = *this;
         return ++r;
     }
 
-    fslist_iterator<dty_, nty_>& operator--() noexcept
+    fslist_iterator& operator--() noexcept
     {
         return static_cast<fslist_iterator&>( super::operator--() );
     }
-    fslist_iterator<dty_, nty_> operator--( int ) noexcept
+    fslist_iterator operator--( int ) noexcept
     {
         auto r = *this;
         return ++r;
@@ -374,13 +734,41 @@ public:
     operator super() const noexcept { return static_cast<super&>( *this ); }
 };
 
+//! @brief      Value storage of fslist_base, addressed by node index.
+//! @details    Values of single array lists are addressed directly.
+template <typename dty_, bool chunked_>
+struct fslist_storage
+{
+    dty_* varray_;
+
+    dty_* at_( size_t n ) const noexcept { return varray_ + n; }
+};
+
+//! @brief      Value storage split into chunks of (1 << chunk_bits_) values.
+//! @details    Value of node index n lives in chunk (n >> chunk_bits_).
+template <typename dty_>
+struct fslist_storage<dty_, true>
+{
+    dty_**   chunks_;
+    unsigned chunk_bits_;
+    size_t   chunk_mask_;
+
+    dty_* at_( size_t n ) const noexcept
+    {
+        return chunks_[n >> chunk_bits_] + ( n & chunk_mask_ );
+    }
+};
+
 //! @brief      Base class for list
 //! @details
 //!              It provides an interface that can be used similar to a list of
 //!             common STL containers. Complex behaviors, such as nodes managed
 //!             by indexes, are simplified by implementing them in classes that
 //!             inherit them.
-template <typename dty_, typename nty_ = size_t>
+//! @tparam chunked_ Store values in chunks through a table, which lets them
+//!             stay in place while capacity grows. Single array lists address
+//!             values directly.
+template <typename dty_, typename nty_ = size_t, bool chunked_ = false>
 class fslist_base : public fslist_alloc_base<nty_>
 {
 public:
@@ -393,8 +781,9 @@ public:
     using const_pointer   = value_type const*;
     using const_reference = value_type const;
     using node_type       = fslist_node<size_type>;
-    using iterator        = fslist_iterator<value_type, size_type>;
-    using const_iterator  = fslist_const_iterator<value_type, size_type>;
+    using iterator        = fslist_iterator<value_type, size_type, chunked_>;
+    using const_iterator
+      = fslist_const_iterator<value_type, size_type, chunked_>;
     using super           = fslist_alloc_base<nty_>;
     enum
     {
@@ -404,42 +793,154 @@ public:
 public:
     ~fslist_base() noexcept { clear(); }
 
+    //! @brief      Destroy every element. O(1) if value type is trivially
+    //!             destructible, and no shared list borrows from this pool.
     void clear() noexcept
     {
-        for ( size_type i = super::head(); i != NODE_NONE; ) {
-            varray_[i].~value_type();
-            auto k = i;
-            i      = super::next( i );
-            super::dealloc_node( k );
+        if constexpr ( std::is_trivially_destructible_v<value_type> ) {
+            if ( super::reset_nodes() )
+                return;
         }
+        clear_( super::links() );
     }
 
-    fslist_base(
+    constexpr fslist_base(
       size_type  capacity,
       pointer    varray,
-      node_type* narray ) noexcept
-        : super_type( capacity, narray )
-        , varray_( varray )
+      node_type* narray,
+      uint64_t*  live ) noexcept
+        : super_type( capacity, narray, live )
+        , storage_{ varray }
+    {
+        static_assert( !chunked_, "Chunked list takes chunk table" );
+    }
+
+protected:
+    //! @brief      Constructs list which stores values in chunks.
+    //! @details
+    //!              Value of node index n is stored at chunks[n >> chunk_bits].
+    //!             Derived class owns the chunk table, and must replace it
+    //!             with set_chunks() when it's reallocated.
+    constexpr fslist_base(
+      size_type  capacity,
+      pointer*   chunks,
+      unsigned   chunk_bits,
+      node_type* narray,
+      uint64_t*  live ) noexcept
+        : super_type( capacity, narray, live )
+        , storage_{ chunks, chunk_bits, ( size_t( 1 ) << chunk_bits ) - 1 }
+    {
+        static_assert( chunked_, "Single array list takes value array" );
+    }
+
+    void set_chunks( pointer* chunks ) noexcept { storage_.chunks_ = chunks; }
+
+public:
+    //! @brief      Relocate elements so that list order matches memory order.
+    //! @details
+    //!              After defragmentation, iteration sweeps node and value
+    //!             arrays linearly. Elements are moved with move constructor.
+    //!             Iterators and indexes to moved elements are invalidated;
+    //!             relocated( from, to ) is invoked with old and new index of
+    //!             each moved element (see fs_idx__()), to fix them up.
+    template <typename relocated_fn__>
+    void defragment( relocated_fn__&& relocated ) noexcept
+    {
+        super::compact_nodes(
+          [this]( size_type from, size_type to, bool swap ) {
+              auto a = value_at_( from );
+              auto b = value_at_( to );
+              if ( swap ) {
+                  value_type tmp( std::move( *b ) );
+                  b->~value_type();
+                  new ( b ) value_type( std::move( *a ) );
+                  a->~value_type();
+                  new ( a ) value_type( std::move( tmp ) );
+              }
+              else {
+                  new ( b ) value_type( std::move( *a ) );
+                  a->~value_type();
+              }
+          },
+          std::forward<relocated_fn__>( relocated ) );
+    }
+    void defragment() noexcept
+    {
+        defragment( []( size_type, size_type ) {} );
+    }
+
+    //! @brief      Visit every live element in index order, regardless of
+    //!             list order.
+    //! @details
+    //!              Scans occupancy bitmap 64 nodes per word, without chasing
+    //!             links. Elements of shared lists drawing from this pool are
+    //!             visited too. fn( value ) only gets the value, and must not
+    //!             insert or erase any element.
+    template <typename fn__>
+    void for_each_live( fn__&& fn )
+    {
+        for_each_live( std::forward<fn__>( fn ), 0, 1 );
+    }
+
+    //! @brief      Visit live elements of partition 'part' out of 'num_parts'.
+    //! @details
+    //!              Bitmap words are split evenly between partitions, which
+    //!             never overlap. Thus distinct partitions can be visited from
+    //!             different threads at once, as long as the list isn't
+    //!             modified meanwhile.
+    template <typename fn__>
+    void for_each_live( fn__&& fn, size_t part, size_t num_parts )
+    {
+        uassert( part < num_parts );
+        size_t const words = super::live_words();
+        size_t const first = words * part / num_parts;
+        size_t const last  = words * ( part + 1 ) / num_parts;
+        auto const   live  = super::live();
+
+        for ( size_t w = first; w < last; ++w ) {
+            for ( uint64_t bits = live[w]; bits; bits &= bits - 1 ) {
+                auto i = static_cast<size_type>( w * 64 + bit_ctz64( bits ) );
+                fn( *value_at_( i ) );
+            }
+        }
+    }
+
+    //! @brief      Construct element at the front.
+    //! @returns    nullptr if the list is full, and could not grow.
+    template <typename... arg_>
+    pointer try_emplace_front( arg_&&... args ) noexcept
     {
+        auto& l = super::links();
+        return ptr_of_(
+          emplace_at_( l, l.head_, std::forward<arg_>( args )... ) );
     }
 
+    //! @brief      Construct element at the back.
+    //! @returns    nullptr if the list is full, and could not grow.
+    template <typename... arg_>
+    pointer try_emplace_back( arg_&&... args ) noexcept
+    {
+        return ptr_of_( emplace_at_(
+          super::links(), NODE_NONE, std::forward<arg_>( args )... ) );
+    }
+
+    //! @warning    List must have room, or be able to grow. Otherwise use
+    //!             try_emplace_front().
     template <typename... arg_>
     reference emplace_front( arg_&&... args ) noexcept
     {
-        auto n = super::alloc_node();
-        super::push_front_node( n );
-        auto p
-          = new ( varray_ + n ) value_type( std::forward<arg_>( args )... );
+        auto p = try_emplace_front( std::forward<arg_>( args )... );
+        uassert( p );
         return *p;
     }
 
+    //! @warning    List must have room, or be able to grow. Otherwise use
+    //!             try_emplace_back().
     template <typename... arg_>
     reference emplace_back( arg_&&... args ) noexcept
     {
-        auto n = super::alloc_node();
-        super::push_back_node( n );
-        auto p
-          = new ( varray_ + n ) value_type( std::forward<arg_>( args )... );
+        auto p = try_emplace_back( std::forward<arg_>( args )... );
+        uassert( p );
         return *p;
     }
 
@@ -447,21 +948,8 @@ public:
 
     void push_front( const_reference arg ) noexcept { emplace_front( arg ); }
 
-    const_iterator cbegin() const noexcept
-    {
-        const_iterator i;
-        i.container_ = this;
-        i.cur_       = super::head();
-        return i;
-    }
-
-    const_iterator cend() const noexcept
-    {
-        const_iterator i;
-        i.container_ = this;
-        i.cur_       = NODE_NONE;
-        return i;
-    }
+    const_iterator cbegin() const noexcept { return iter_( super::head() ); }
+    const_iterator cend() const noexcept { return iter_( NODE_NONE ); }
 
     iterator begin() noexcept
     {
@@ -477,39 +965,33 @@ public:
     const_reference front() const noexcept
     {
         uassert( super::valid_node( super::head() ) );
-        return varray_[super::head()];
+        return *value_at_( super::head() );
     }
 
     const_reference back() const noexcept
     {
         uassert( super::valid_node( super::tail() ) );
-        return varray_[super::tail()];
+        return *value_at_( super::tail() );
     }
 
     reference front() noexcept
     {
         uassert( super::valid_node( super::head() ) );
-        return varray_[super::head()];
+        return *value_at_( super::head() );
     }
 
     reference back() noexcept
     {
         uassert( super::valid_node( super::tail() ) );
-        return varray_[super::tail()];
+        return *value_at_( super::tail() );
     }
 
+    //! @returns    end() if the list is full, and could not grow.
     template <typename... ty__>
     iterator emplace( const_iterator pos, ty__&&... args ) noexcept
     {
-        uassert( super::size() < super::max_size() );
-        auto n = super::alloc_node();
-        super::insert_node( n, pos.cur_ );
-
-        new ( varray_ + n ) value_type( std::forward<ty__>( args )... );
-
-        const_iterator r;
-        r.container_ = this;
-        r.cur_       = n;
+        auto r = iter_( emplace_at_(
+          super::links(), pos.cur_, std::forward<ty__>( args )... ) );
         return static_cast<iterator&>( r );
     }
 
@@ -526,66 +1008,209 @@ public:
         }
     }
 
-    void pop_back() noexcept { release( super::tail() ); }
+    void pop_back() noexcept { release_( super::links(), super::tail() ); }
+
+    void pop_front() noexcept { release_( super::links(), super::head() ); }
+
+    void erase( const_iterator pos ) noexcept
+    {
+        release_( super::links(), pos.cur_ );
+    }
+
+    //! @brief      Move every element of other list before pos. O(1)
+    //! @details
+    //!              Lists must share the same node pool, i.e. other is this
+    //!             list or a @ref upp::shared_fslist drawing from it. Values
+    //!             are never moved, thus iterators stay valid.
+    template <typename list__>
+    void splice( const_iterator pos, list__& other ) noexcept
+    {
+        splice_( super::links(), pos, other, other.cbegin(), other.cend() );
+    }
 
-    void pop_front() noexcept { release( super::head() ); }
+    //! @brief      Move single element of other list before pos. O(1)
+    template <typename list__>
+    void splice( const_iterator pos, list__& other, const_iterator it ) noexcept
+    {
+        splice_( super::links(), pos, other, it, std::next( it ) );
+    }
 
-    void erase( const_iterator pos ) noexcept { release( pos.cur_ ); }
+    //! @brief      Move elements [first, last) of other list before pos.
+    //! @details    O(1) within the same list, otherwise O(n) to count them.
+    template <typename list__>
+    void splice(
+      const_iterator pos,
+      list__&        other,
+      const_iterator first,
+      const_iterator last ) noexcept
+    {
+        splice_( super::links(), pos, other, first, last );
+    }
+
+    //! @brief      Merge other sorted list into this sorted list. Stable.
+    //! @details    Nodes are relinked; no value is moved or copied.
+    template <typename list__, typename less__ = std::less<>>
+    void merge( list__& other, less__&& less = {} ) noexcept
+    {
+        merge_( super::links(), other, std::forward<less__>( less ) );
+    }
+
+    //! @brief      Sort elements by relinking nodes. Stable, O(n log n).
+    //! @details    No value is moved or copied, thus iterators stay valid.
+    template <typename less__ = std::less<>>
+    void sort( less__&& less = {} ) noexcept
+    {
+        sort_( super::links(), std::forward<less__>( less ) );
+    }
+
+    fslist_base& pool__() noexcept { return *this; }
+    auto&        links__() noexcept { return super::links(); }
 
     const_pointer at__( size_type fs_idx ) const noexcept
     {
-        return super::valid_node( fs_idx ) ? varray_ + fs_idx : nullptr;
+        return super::valid_node( fs_idx ) ? value_at_( fs_idx ) : nullptr;
     }
 
     pointer at__( size_type fs_idx ) noexcept
     {
-        return super::valid_node( fs_idx ) ? varray_ + fs_idx : nullptr;
+        return super::valid_node( fs_idx ) ? value_at_( fs_idx ) : nullptr;
     }
 
-private:
-    template <typename ty1_, typename ty2_>
-    friend class fslist_const_iterator;
+    //! @brief      Get iterator of valid node index, see fs_idx__().
+    iterator iter__( size_type fs_idx ) noexcept
+    {
+        uassert( super::valid_node( fs_idx ) );
+        auto r = iter_( fs_idx );
+        return static_cast<iterator&>( r );
+    }
+
+protected:
+    using links_type = typename super::links_type;
+
+    //! @brief      Allocate and construct element before 'at' of given list.
+    //! @returns    NODE_NONE if no node could be allocated.
+    template <typename... ty__>
+    size_type emplace_at_( links_type& l, size_type at, ty__&&... args )
+    {
+        auto n = super::alloc_node();
+        if ( n == NODE_NONE )
+            return NODE_NONE;
 
-    void release( size_type n )
+        super::link_node( l, n, at );
+        new ( value_at_( n ) ) value_type( std::forward<ty__>( args )... );
+        return n;
+    }
+
+    void release_( links_type& l, size_type n ) noexcept
     {
         uassert( n != NODE_NONE );
-        varray_[n].~value_type();
-        super::dealloc_node( n );
+        value_at_( n )->~value_type();
+        super::unlink_node( l, n );
+        super::free_node( n );
+    }
+
+    void clear_( links_type& l ) noexcept
+    {
+        while ( l.head_ != NODE_NONE )
+            release_( l, l.head_ );
     }
 
+    const_iterator iter_( size_type n ) const noexcept
+    {
+        const_iterator i;
+        i.container_ = this;
+        i.cur_       = n;
+        return i;
+    }
+
+    template <typename list__>
+    void splice_(
+      links_type&    dst,
+      const_iterator pos,
+      list__&        other,
+      const_iterator first,
+      const_iterator last ) noexcept
+    {
+        uassert( &other.pool__() == this );
+        auto& src = other.links__();
+        super::splice_nodes(
+          dst,
+          pos.cur_,
+          src,
+          first.cur_,
+          last.cur_,
+          &src == &dst ? 0 : super::count_nodes( first.cur_, last.cur_ ) );
+    }
+
+    template <typename list__, typename less__>
+    void merge_( links_type& dst, list__& other, less__&& less ) noexcept
+    {
+        uassert( &other.pool__() == this );
+        if ( &other.links__() == &dst )
+            return;
+        super::merge_nodes(
+          dst, other.links__(), [&]( size_type a, size_type b ) {
+              return less( *value_at_( a ), *value_at_( b ) );
+          } );
+    }
+
+    template <typename less__>
+    void sort_( links_type& l, less__&& less ) noexcept
+    {
+        super::sort_nodes( l, [&]( size_type a, size_type b ) {
+            return less( *value_at_( a ), *value_at_( b ) );
+        } );
+    }
+
+private:
+    template <typename ty1_, typename ty2_, bool ty3_>
+    friend class fslist_const_iterator;
+    template <typename ty1_, typename ty2_, bool ty3_>
+    friend class upp::shared_fslist;
+
     pointer get_arg( size_type node ) noexcept
     {
         uassert( node != NODE_NONE );
         uassert( super::valid_node( node ) );
-        return varray_ + node;
+        return value_at_( node );
+    }
+
+    pointer value_at_( size_type n ) const noexcept
+    {
+        return storage_.at_( n );
+    }
+
+    pointer ptr_of_( size_type n ) const noexcept
+    {
+        return n != NODE_NONE ? value_at_( n ) : nullptr;
     }
 
 private:
-    pointer varray_;
+    fslist_storage<value_type, chunked_> storage_;
 };
 
-template <typename dty_, typename nty_>
-inline fslist_const_iterator<dty_, nty_>&
-fslist_const_iterator<dty_, nty_>::operator++() noexcept
+template <typename dty_, typename nty_, bool chunked_>
+inline fslist_const_iterator<dty_, nty_, chunked_>&
+fslist_const_iterator<dty_, nty_, chunked_>::operator++() noexcept
 {
     uassert( container_ && cur_ != NODE_NONE );
     cur_ = container_->next( cur_ );
     return *this;
 }
 
-template <typename dty_, typename nty_>
-inline fslist_const_iterator<dty_, nty_>
-fslist_const_iterator<dty_, nty_>::operator++( int ) noexcept
+template <typename dty_, typename nty_, bool chunked_>
+inline fslist_const_iterator<dty_, nty_, chunked_>
+fslist_const_iterator<dty_, nty_, chunked_>::operator++( int ) noexcept
 {
     auto ret = *this;
     return ++ret;
 }
 
-template <typename dty_, typename nty_>
-inline fslist_const_iterator<dty_, nty_>&
-fslist_const_iterator<dty_, nty_>::operator--() noexcept
+template <typename dty_, typename nty_, bool chunked_>
+inline fslist_const_iterator<dty_, nty_, chunked_>&
+fslist_const_iterator<dty_, nty_, chunked_>::operator--() noexcept
 {
-    uassert( container_ && cur_ != container_.head() );
+    uassert( container_ && cur_ != container_->head() );
     if ( cur_ == NODE_NONE ) {
         cur_ = container_->tail();
     }
@@ -595,28 +1220,28 @@ fslist_const_iterator<dty_, nty_>::operator--() noexcept
     return *this;
 }
 
-template <typename dty_, typename nty_>
-inline fslist_const_iterator<dty_, nty_>
-fslist_const_iterator<dty_, nty_>::operator--( int ) noexcept
+template <typename dty_, typename nty_, bool chunked_>
+inline fslist_const_iterator<dty_, nty_, chunked_>
+fslist_const_iterator<dty_, nty_, chunked_>::operator--( int ) noexcept
 {
     auto ret = *this;
     return --ret;
 }
 
-template <typename dty_, typename nty_>
-inline typename fslist_const_iterator<dty_, nty_>::reference
-fslist_const_iterator<dty_, nty_>::operator*() const noexcept
+template <typename dty_, typename nty_, bool chunked_>
+inline typename fslist_const_iterator<dty_, nty_, chunked_>::reference
+fslist_const_iterator<dty_, nty_, chunked_>::operator*() const noexcept
 {
-    auto c = static_cast<fslist_base<dty_, nty_>*>(
+    auto c = static_cast<fslist_base<dty_, nty_, chunked_>*>(
       const_cast<fslist_alloc_base<nty_>*>( container_ ) );
     return *c->get_arg( cur_ );
 }
 
-template <typename dty_, typename nty_>
-inline typename fslist_const_iterator<dty_, nty_>::pointer
-fslist_const_iterator<dty_, nty_>::operator->() const noexcept
+template <typename dty_, typename nty_, bool chunked_>
+inline typename fslist_const_iterator<dty_, nty_, chunked_>::pointer
+fslist_const_iterator<dty_, nty_, chunked_>::operator->() const noexcept
 {
-    auto c = static_cast<fslist_base<dty_, nty_>*>(
+    auto c = static_cast<fslist_base<dty_, nty_, chunked_>*>(
       const_cast<fslist_alloc_base<nty_>*>( container_ ) );
     return c->get_arg( cur_ );
 }
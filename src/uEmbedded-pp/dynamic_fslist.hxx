@@ -0,0 +1,212 @@
+//! @brief      Growable free space list
+//! @file       dynamic_fslist.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             Free space list which allocates its storage from heap, one
+//!             chunk at a time, as the list grows.
+#pragma once
+#include <new>
+#include <stdlib.h>
+#include "__fslist_base.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @weakgroup  uEmbedded_Cpp_FreeSpaceList
+//! @{
+
+//! @brief      Free space list whose capacity follows its working set.
+//! @details
+//!              Values are stored in fixed size chunks which never move, and
+//!             nodes are kept in single array which is reallocated on growth.
+//!             Node index n always refers to slot (n & chunk mask) of chunk
+//!             (n >> chunk_bits__), thus iterators, indexes and references to
+//!             values stay valid across growth. \n
+//!              A new chunk is linked when an element is inserted into full
+//!             list. shrink_to_fit() releases trailing chunks which hold no
+//!             active element.
+//! @tparam chunk_bits__ Log2 of number of elements in single chunk.
+template <
+  typename value_ty__,
+  typename size_ty__ = size_t,
+  size_t chunk_bits__ = 8>
+class dynamic_fslist : public impl::fslist_base<value_ty__, size_ty__, true>
+{
+public:
+    using super           = impl::fslist_base<value_ty__, size_ty__, true>;
+    using value_type      = value_ty__;
+    using size_type       = size_ty__;
+    using difference_type = ptrdiff_t;
+    using pointer         = value_type*;
+    using reference       = value_type&;
+    using const_pointer   = value_type const*;
+    using const_reference = value_type const;
+    using iterator        = typename super::iterator;
+    using const_iterator  = typename super::const_iterator;
+    using node_type       = typename super::node_type;
+
+    enum : size_t
+    {
+        CHUNK_SIZE = size_t( 1 ) << chunk_bits__,
+
+        //! Node index NODE_NONE must not be reachable.
+        MAX_CHUNKS = size_t( super::NODE_NONE ) / CHUNK_SIZE
+    };
+    static_assert( MAX_CHUNKS > 0, "Chunk is larger than size type" );
+
+public:
+    dynamic_fslist() noexcept
+        : super( 0, nullptr, chunk_bits__, nullptr, nullptr )
+        , chunks_( nullptr )
+        , num_chunks_( 0 )
+    {
+        super::set_grow( &grow_ );
+    }
+
+    //! @brief      Construct with initial capacity.
+    explicit dynamic_fslist( size_t capacity ) noexcept : dynamic_fslist()
+    {
+        reserve( capacity );
+    }
+
+    ~dynamic_fslist() noexcept
+    {
+        super::clear();
+        for ( size_t i = 0; i < num_chunks_; ++i )
+            free_chunk_( chunks_[i] );
+        free( chunks_ );
+        free( super::nodes() );
+        free( super::live() );
+    }
+
+    dynamic_fslist( dynamic_fslist const& ) = delete;
+    dynamic_fslist& operator=( dynamic_fslist const& ) = delete;
+
+    //! @brief      Get maximum number of nodes which can be allocated.
+    size_type max_size() const noexcept
+    {
+        return static_cast<size_type>( MAX_CHUNKS * CHUNK_SIZE );
+    }
+
+    //! @brief      Get number of nodes allocated currently.
+    size_type capacity() const noexcept { return super::max_size(); }
+
+    //! @brief      Extend capacity to hold at least given number of elements.
+    //! @returns    false on allocation failure.
+    bool reserve( size_t capacity ) noexcept
+    {
+        while ( super::max_size() < capacity ) {
+            if ( !grow_chunk_() )
+                return false;
+        }
+        return true;
+    }
+
+    //! @brief      Release trailing chunks which hold no active element.
+    void shrink_to_fit() noexcept
+    {
+        size_t keep = ( size_t( super::live_end() ) + CHUNK_SIZE - 1 )
+                      >> chunk_bits__;
+        if ( keep == num_chunks_ )
+            return;
+
+        super::truncate_nodes(
+          static_cast<size_type>( keep << chunk_bits__ ) );
+        for ( size_t i = keep; i < num_chunks_; ++i )
+            free_chunk_( chunks_[i] );
+        num_chunks_ = keep;
+
+        if ( keep == 0 ) {
+            free( super::nodes() );
+            free( super::live() );
+            super::set_live( nullptr );
+            super::set_nodes( nullptr, 0 );
+            return;
+        }
+
+        // Shrinking realloc may fail; then the larger blocks are kept.
+        auto nodes = static_cast<node_type*>( realloc(
+          super::nodes(), ( keep << chunk_bits__ ) * sizeof( node_type ) ) );
+        if ( nodes )
+            super::set_nodes( nodes, super::max_size() );
+
+        auto live = static_cast<uint64_t*>( realloc(
+          super::live(),
+          super::live_words_of( keep << chunk_bits__ ) * sizeof( uint64_t ) ) );
+        if ( live )
+            super::set_live( live );
+
+        auto chunks = static_cast<pointer*>(
+          realloc( chunks_, keep * sizeof( pointer ) ) );
+        if ( chunks ) {
+            chunks_ = chunks;
+            super::set_chunks( chunks );
+        }
+    }
+
+private:
+    static void grow_( impl::fslist_alloc_base<size_ty__>* s ) noexcept
+    {
+        static_cast<dynamic_fslist*>( s )->grow_chunk_();
+    }
+
+    bool grow_chunk_() noexcept
+    {
+        if ( num_chunks_ == MAX_CHUNKS )
+            return false;
+
+        size_t const new_cap = ( num_chunks_ + 1 ) << chunk_bits__;
+
+        auto chunk = static_cast<pointer>( ::operator new(
+          sizeof( value_type ) << chunk_bits__,
+          std::align_val_t( alignof( value_type ) ),
+          std::nothrow ) );
+        if ( chunk == nullptr )
+            return false;
+
+        auto chunks = static_cast<pointer*>(
+          realloc( chunks_, ( num_chunks_ + 1 ) * sizeof( pointer ) ) );
+        if ( chunks == nullptr ) {
+            free_chunk_( chunk );
+            return false;
+        }
+        chunks_ = chunks;
+        super::set_chunks( chunks );
+
+        auto live = static_cast<uint64_t*>( realloc(
+          super::live(),
+          super::live_words_of( new_cap ) * sizeof( uint64_t ) ) );
+        if ( live == nullptr ) {
+            free_chunk_( chunk );
+            return false;
+        }
+        super::set_live( live );
+
+        auto nodes = static_cast<node_type*>(
+          realloc( super::nodes(), new_cap * sizeof( node_type ) ) );
+        if ( nodes == nullptr ) {
+            free_chunk_( chunk );
+            return false;
+        }
+
+        chunks_[num_chunks_++] = chunk;
+        super::set_nodes( nodes, static_cast<size_type>( new_cap ) );
+        return true;
+    }
+
+    static void free_chunk_( pointer chunk ) noexcept
+    {
+        ::operator delete( chunk, std::align_val_t( alignof( value_type ) ) );
+    }
+
+private:
+    pointer* chunks_;
+    size_t   num_chunks_;
+};
+
+//! @}
+//! @}
+} // namespace upp
@@ -0,0 +1,61 @@
+//! @brief      Parallel sweep over free space list elements
+//! @file       fslist_parallel.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             Splits occupancy bitmap of a free space list across threads, so
+//!             that bulk sweeps over large pools (timeouts, statistics) don't
+//!             serialize on list links.
+#pragma once
+#include <thread>
+#include <vector>
+#include "__fslist_base.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @weakgroup  uEmbedded_Cpp_FreeSpaceList
+//! @{
+
+//! @brief      Visit every live element of list from multiple threads.
+//! @details
+//!              Calling thread takes the first partition. Elements are visited
+//!             in no particular order, and fn( value ) is invoked concurrently,
+//!             thus it must be thread safe. List must not be modified until
+//!             this returns.
+//! @param      num_threads Number of threads including the calling one.
+template <typename list__, typename fn__>
+void for_each_live_parallel(
+  list__& list,
+  fn__&&  fn,
+  size_t  num_threads = std::thread::hardware_concurrency() )
+{
+    // Partitions smaller than this aren't worth a thread.
+    constexpr size_t min_words = 16;
+
+    if ( num_threads > list.live_words() / min_words )
+        num_threads = list.live_words() / min_words;
+    if ( num_threads < 2 ) {
+        list.for_each_live( fn );
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve( num_threads - 1 );
+    for ( size_t i = 1; i < num_threads; ++i ) {
+        workers.emplace_back(
+          [&list, &fn, i, num_threads] {
+              list.for_each_live( fn, i, num_threads );
+          } );
+    }
+
+    list.for_each_live( fn, 0, num_threads );
+    for ( auto& w : workers )
+        w.join();
+}
+
+//! @}
+//! @}
+} // namespace upp
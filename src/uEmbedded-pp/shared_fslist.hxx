@@ -0,0 +1,202 @@
+//! @brief      List which borrows nodes from another free space list
+//! @file       shared_fslist.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             Several lists can draw nodes from single free space list, which
+//!             then acts as a shared pool. Elements move between lists of the
+//!             same pool by splice() in O(1), without copying any value.
+#pragma once
+#include "__fslist_base.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @weakgroup  uEmbedded_Cpp_FreeSpaceList
+//! @{
+
+//! @brief      List whose nodes are allocated from other fslist.
+//! @details
+//!              Pool must outlive the list. Pool's own elements and elements
+//!             of every shared list count against its capacity. Iterators of
+//!             this list refer to the pool, thus end() of this list can't be
+//!             decremented.
+//! @tparam chunked__ Set to borrow from @ref upp::dynamic_fslist.
+template <
+  typename value_ty__,
+  typename size_ty__ = size_t,
+  bool chunked__     = false>
+class shared_fslist
+{
+public:
+    using pool_type       = impl::fslist_base<value_ty__, size_ty__, chunked__>;
+    using value_type      = value_ty__;
+    using size_type       = size_ty__;
+    using difference_type = ptrdiff_t;
+    using pointer         = value_type*;
+    using reference       = value_type&;
+    using const_pointer   = value_type const*;
+    using const_reference = value_type const&;
+    using iterator        = typename pool_type::iterator;
+    using const_iterator  = typename pool_type::const_iterator;
+    using links_type      = typename pool_type::links_type;
+    enum : size_type
+    {
+        NODE_NONE = pool_type::NODE_NONE
+    };
+
+public:
+    explicit shared_fslist( pool_type& pool ) noexcept
+        : pool_( &pool )
+        , list_{ NODE_NONE, NODE_NONE, 0 }
+    {
+    }
+    ~shared_fslist() noexcept { clear(); }
+
+    shared_fslist( shared_fslist const& ) = delete;
+    shared_fslist& operator=( shared_fslist const& ) = delete;
+
+    //! @brief      Return every element to the pool.
+    void clear() noexcept { pool_->clear_( list_ ); }
+
+    size_type size() const noexcept { return list_.size_; }
+    bool      empty() const noexcept { return list_.size_ == 0; }
+
+    //! @returns    nullptr if the pool is full, and could not grow.
+    template <typename... arg_>
+    pointer try_emplace_front( arg_&&... args ) noexcept
+    {
+        return pool_->ptr_of_( pool_->emplace_at_(
+          list_, list_.head_, std::forward<arg_>( args )... ) );
+    }
+
+    //! @returns    nullptr if the pool is full, and could not grow.
+    template <typename... arg_>
+    pointer try_emplace_back( arg_&&... args ) noexcept
+    {
+        return pool_->ptr_of_( pool_->emplace_at_(
+          list_, NODE_NONE, std::forward<arg_>( args )... ) );
+    }
+
+    //! @warning    Pool must have room, or be able to grow.
+    template <typename... arg_>
+    reference emplace_front( arg_&&... args ) noexcept
+    {
+        auto p = try_emplace_front( std::forward<arg_>( args )... );
+        uassert( p );
+        return *p;
+    }
+
+    //! @warning    Pool must have room, or be able to grow.
+    template <typename... arg_>
+    reference emplace_back( arg_&&... args ) noexcept
+    {
+        auto p = try_emplace_back( std::forward<arg_>( args )... );
+        uassert( p );
+        return *p;
+    }
+
+    //! @returns    end() if the pool is full, and could not grow.
+    template <typename... arg_>
+    iterator emplace( const_iterator pos, arg_&&... args ) noexcept
+    {
+        auto r = pool_->iter_( pool_->emplace_at_(
+          list_, pos.fs_idx__(), std::forward<arg_>( args )... ) );
+        return static_cast<iterator&>( r );
+    }
+
+    reference push_back( value_type const& v ) noexcept
+    {
+        return emplace_back( v );
+    }
+    reference push_front( value_type const& v ) noexcept
+    {
+        return emplace_front( v );
+    }
+
+    void pop_back() noexcept { pool_->release_( list_, list_.tail_ ); }
+    void pop_front() noexcept { pool_->release_( list_, list_.head_ ); }
+    void erase( const_iterator pos ) noexcept
+    {
+        pool_->release_( list_, pos.fs_idx__() );
+    }
+
+    reference front() noexcept { return *pool_->value_at_( list_.head_ ); }
+    reference back() noexcept { return *pool_->value_at_( list_.tail_ ); }
+    const_reference front() const noexcept
+    {
+        return *pool_->value_at_( list_.head_ );
+    }
+    const_reference back() const noexcept
+    {
+        return *pool_->value_at_( list_.tail_ );
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return pool_->iter_( list_.head_ );
+    }
+    const_iterator cend() const noexcept { return pool_->iter_( NODE_NONE ); }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+    iterator       begin() noexcept
+    {
+        auto r = cbegin();
+        return static_cast<iterator&>( r );
+    }
+    iterator end() noexcept
+    {
+        auto r = cend();
+        return static_cast<iterator&>( r );
+    }
+
+    //! @brief      Move every element of other list before pos. O(1)
+    template <typename list__>
+    void splice( const_iterator pos, list__& other ) noexcept
+    {
+        pool_->splice_( list_, pos, other, other.cbegin(), other.cend() );
+    }
+
+    template <typename list__>
+    void splice( const_iterator pos, list__& other, const_iterator it ) noexcept
+    {
+        pool_->splice_( list_, pos, other, it, std::next( it ) );
+    }
+
+    template <typename list__>
+    void splice(
+      const_iterator pos,
+      list__&        other,
+      const_iterator first,
+      const_iterator last ) noexcept
+    {
+        pool_->splice_( list_, pos, other, first, last );
+    }
+
+    //! @brief      Merge other sorted list into this sorted list. Stable.
+    template <typename list__, typename less__ = std::less<>>
+    void merge( list__& other, less__&& less = {} ) noexcept
+    {
+        pool_->merge_( list_, other, std::forward<less__>( less ) );
+    }
+
+    //! @brief      Sort elements by relinking nodes. Stable, O(n log n).
+    template <typename less__ = std::less<>>
+    void sort( less__&& less = {} ) noexcept
+    {
+        pool_->sort_( list_, std::forward<less__>( less ) );
+    }
+
+    pool_type&  pool__() noexcept { return *pool_; }
+    links_type& links__() noexcept { return list_; }
+
+private:
+    pool_type* pool_;
+    links_type list_;
+};
+
+//! @}
+//! @}
+} // namespace upp
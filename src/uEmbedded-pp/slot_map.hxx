@@ -0,0 +1,267 @@
+//! @brief      Generational slot map
+//! @file       slot_map.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             Stores values densely, and refers to them by handles which pack
+//!             slot index with generation of the slot. Stale handles are
+//!             detected by single comparison of generation.
+#pragma once
+#include <new>
+#include <stdlib.h>
+#include <type_traits>
+#include "__fslist_base.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @defgroup   uEmbedded_Cpp_SlotMap
+//! @brief      Generational slot map
+//! @{
+
+//! @brief      Fixed capacity container addressed by generation-checked
+//!             handles.
+//! @details
+//!              Values are kept contiguous in insertion order until erased;
+//!             erase moves the last value into the hole. Each slot maps a
+//!             handle to current position of its value, and slots themselves
+//!             are recycled by @ref upp::impl::fslist_alloc_base. Generation of
+//!             a slot is bumped on both emplace and erase, so it's odd while
+//!             the slot is live, and even while it's free. Erase thus
+//!             invalidates every handle to the slot, and handles with even
+//!             generation, including HANDLE_NONE, are never valid.
+//! @tparam index_ty__ Slot index type. Handle is twice as wide; e.g. uint16_t
+//!             gives 32-bit handles, uint32_t gives 64-bit ones.
+template <typename value_ty__, typename index_ty__ = uint32_t>
+class slot_map : private impl::fslist_alloc_base<index_ty__>
+{
+    static_assert(
+      std::is_unsigned_v<index_ty__> && sizeof( index_ty__ ) <= 4,
+      "Handle must fit in 64 bits" );
+    using super = impl::fslist_alloc_base<index_ty__>;
+
+public:
+    using value_type      = value_ty__;
+    using size_type       = index_ty__;
+    using difference_type = ptrdiff_t;
+    using pointer         = value_type*;
+    using reference       = value_type&;
+    using const_pointer   = value_type const*;
+    using const_reference = value_type const&;
+    using iterator        = pointer;
+    using const_iterator  = const_pointer;
+    using handle_type     = std::conditional_t<
+      sizeof( index_ty__ ) <= 2,
+      uint32_t,
+      uint64_t>;
+
+    enum : handle_type
+    {
+        HANDLE_NONE = 0
+    };
+
+public:
+    //! @brief      Allocate storage for given number of values.
+    //! @details    On allocation failure, capacity() becomes 0.
+    explicit slot_map( size_type capacity ) noexcept
+        : super( 0, nullptr, nullptr )
+    {
+        uassert( capacity < super::NODE_NONE );
+
+        size_t const words = super::live_words_of( capacity );
+        auto         block = malloc(
+          words * sizeof( uint64_t ) + capacity * sizeof( node_type )
+          + capacity * sizeof( size_type ) * 3 );
+        values_ = static_cast<pointer>( ::operator new(
+          sizeof( value_type ) * ( capacity ? capacity : 1 ),
+          std::align_val_t( alignof( value_type ) ),
+          std::nothrow ) );
+
+        if ( block == nullptr || values_ == nullptr ) {
+            free( block );
+            free_values_();
+            values_ = nullptr;
+            return;
+        }
+
+        auto live  = static_cast<uint64_t*>( block );
+        auto nodes = reinterpret_cast<node_type*>( live + words );
+        gen_       = reinterpret_cast<size_type*>( nodes + capacity );
+        dense_     = gen_ + capacity;
+        slot_of_   = dense_ + capacity;
+
+        // Even generation marks free slot, which no handle can match.
+        for ( size_type i = 0; i < capacity; ++i )
+            gen_[i] = 0;
+
+        super::set_live( live );
+        super::set_nodes( nodes, capacity );
+    }
+
+    ~slot_map() noexcept
+    {
+        clear();
+        free( super::live() );
+        free_values_();
+    }
+
+    slot_map( slot_map const& ) = delete;
+    slot_map& operator=( slot_map const& ) = delete;
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return super::max_size(); }
+    bool      empty() const noexcept { return size_ == 0; }
+    bool      full() const noexcept { return size_ == capacity(); }
+
+    //! @brief      Construct new value.
+    //! @returns    HANDLE_NONE if the map is full.
+    template <typename... arg_>
+    handle_type emplace( arg_&&... args )
+    {
+        if ( full() )
+            return HANDLE_NONE;
+
+        // Value goes to the free end of dense array, so a throwing
+        // constructor leaves no slot allocated.
+        new ( values_ + size_ ) value_type( std::forward<arg_>( args )... );
+        size_type slot = super::alloc_node();
+
+        ++gen_[slot];
+        dense_[slot]    = size_;
+        slot_of_[size_] = slot;
+        ++size_;
+        return pack_( slot, gen_[slot] );
+    }
+
+    handle_type insert( value_type const& v ) { return emplace( v ); }
+    handle_type insert( value_type&& v ) { return emplace( std::move( v ) ); }
+
+    //! @brief      Check if handle refers to live value. O(1)
+    bool contains( handle_type h ) const noexcept
+    {
+        size_type slot = index_of( h );
+        size_type gen  = generation_of( h );
+        return ( gen & 1 ) && slot < capacity() && gen_[slot] == gen;
+    }
+
+    //! @returns    nullptr if the handle is stale.
+    pointer find( handle_type h ) noexcept
+    {
+        return contains( h ) ? values_ + dense_[index_of( h )] : nullptr;
+    }
+    const_pointer find( handle_type h ) const noexcept
+    {
+        return contains( h ) ? values_ + dense_[index_of( h )] : nullptr;
+    }
+
+    reference operator[]( handle_type h ) noexcept
+    {
+        uassert( contains( h ) );
+        return values_[dense_[index_of( h )]];
+    }
+    const_reference operator[]( handle_type h ) const noexcept
+    {
+        uassert( contains( h ) );
+        return values_[dense_[index_of( h )]];
+    }
+
+    //! @brief      Destroy value, moving the last value into its place.
+    //! @details    Iterators and pointers to the last value are invalidated.
+    //! @returns    false if the handle is stale.
+    bool erase( handle_type h ) noexcept
+    {
+        if ( !contains( h ) )
+            return false;
+
+        release_( index_of( h ) );
+        return true;
+    }
+
+    //! @brief      Erase value at given position of dense array.
+    iterator erase( const_iterator pos ) noexcept
+    {
+        auto i = static_cast<size_type>( pos - values_ );
+        uassert( i < size_ );
+        release_( slot_of_[i] );
+        return values_ + i;
+    }
+
+    //! @brief      Destroy every value, and invalidate every handle.
+    void clear() noexcept
+    {
+        while ( size_ )
+            release_( slot_of_[size_ - 1] );
+    }
+
+    //! @brief      Get handle of value at given position of dense array.
+    handle_type handle_of( const_iterator pos ) const noexcept
+    {
+        auto i = static_cast<size_type>( pos - values_ );
+        uassert( i < size_ );
+        return pack_( slot_of_[i], gen_[slot_of_[i]] );
+    }
+
+    iterator       begin() noexcept { return values_; }
+    iterator       end() noexcept { return values_ + size_; }
+    const_iterator begin() const noexcept { return values_; }
+    const_iterator end() const noexcept { return values_ + size_; }
+    const_iterator cbegin() const noexcept { return values_; }
+    const_iterator cend() const noexcept { return values_ + size_; }
+    pointer        data() noexcept { return values_; }
+    const_pointer  data() const noexcept { return values_; }
+
+    static constexpr size_type index_of( handle_type h ) noexcept
+    {
+        return static_cast<size_type>( h );
+    }
+    static constexpr size_type generation_of( handle_type h ) noexcept
+    {
+        return static_cast<size_type>( h >> ( sizeof( size_type ) * 8 ) );
+    }
+
+private:
+    using node_type = typename super::node_type;
+
+    static constexpr handle_type pack_( size_type slot, size_type gen ) noexcept
+    {
+        return handle_type( gen ) << ( sizeof( size_type ) * 8 ) | slot;
+    }
+
+    void release_( size_type slot ) noexcept
+    {
+        size_type pos  = dense_[slot];
+        size_type last = size_ - 1;
+
+        values_[pos].~value_type();
+        if ( pos != last ) {
+            new ( values_ + pos ) value_type( std::move( values_[last] ) );
+            values_[last].~value_type();
+            slot_of_[pos]         = slot_of_[last];
+            dense_[slot_of_[pos]] = pos;
+        }
+        --size_;
+
+        // Becomes even. Wraps around to 0 from the odd maximum.
+        ++gen_[slot];
+        super::free_node( slot );
+    }
+
+    void free_values_() noexcept
+    {
+        ::operator delete(
+          values_, std::align_val_t( alignof( value_type ) ) );
+    }
+
+private:
+    pointer    values_  = nullptr;
+    size_type* gen_     = nullptr;
+    size_type* dense_   = nullptr;
+    size_type* slot_of_ = nullptr;
+    size_type  size_    = 0;
+};
+
+//! @}
+//! @}
+} // namespace upp
@@ -8,6 +8,15 @@ namespace upp {
 
 //! \brief       A simple wrapper class that allocates static memory for nodes
 //!             and data buffers.
+//! \details
+//!              Buffers are left uninitialized; elements are constructed only
+//!             when inserted, thus value type doesn't need to be default
+//!             constructible. \n
+//!              The constructor is deliberately not constexpr. The list holds
+//!             pointers into itself, so constant initialization would emit the
+//!             whole instance, buffers included, as initialized data. Static
+//!             instances are rather placed in .bss, and the O(1) constructor
+//!             only sets up the header at startup.
 template <typename value_ty__, typename size_ty__, size_t cap__>
 class static_fslist : public impl::fslist_base<value_ty__, size_ty__>
 {
@@ -24,11 +33,25 @@ public:
     using const_iterator  = typename super::const_iterator;
 
 public:
-    static_fslist() : super( cap__, &vbuf[0], &nbuf[0] ) { }
+    static_fslist() noexcept
+        : super( cap__, &vbuf_.v_[0], &nbuf_.v_[0], &lbuf_.v_[0] )
+    {
+    }
 
 private:
-    value_ty__                   vbuf[cap__];
-    impl::fslist_node<size_ty__> nbuf[cap__];
+    //! Raw storage of ty__ array which is neither constructed nor destroyed.
+    template <typename ty__, size_t num__ = cap__>
+    union storage_
+    {
+        storage_() noexcept { }
+        ~storage_() noexcept { }
+
+        ty__ v_[num__];
+    };
+
+    storage_<value_ty__>                   vbuf_;
+    storage_<impl::fslist_node<size_ty__>> nbuf_;
+    storage_<uint64_t, super::live_words_of( cap__ )> lbuf_;
 };
 
 //! @}
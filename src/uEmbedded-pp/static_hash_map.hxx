@@ -0,0 +1,406 @@
+//! @brief      Fixed capacity open addressing hash map
+//! @file       static_hash_map.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             Hash map whose slots are stored inside the object. It never
+//!             allocates, and never rehashes by itself, thus every operation
+//!             has bounded latency. Tombstones left by erase are purged only
+//!             when purge() is called.
+#pragma once
+#include <new>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+#include "../uEmbedded/bitops.h"
+#include "../uEmbedded/uassert.h"
+#include "utility.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @defgroup   uEmbedded_Cpp_HashMap
+//! @brief      Fixed capacity hash containers
+//! @{
+
+namespace impl {
+//! @brief      Control bytes of 8 slots, matched at once within single word.
+//! @details
+//!              Each slot has one control byte; EMPTY, DELETED, or lower 7
+//!             bits of the key hash when it's full. Group is loaded as little
+//!             endian word, so byte n of group is byte n of the word.
+struct hash_ctrl_group
+{
+    enum : uint8_t
+    {
+        EMPTY   = 0x80,
+        DELETED = 0xfe,
+        WIDTH   = 8
+    };
+
+    static constexpr uint64_t LSBS = 0x0101010101010101ull;
+    static constexpr uint64_t MSBS = 0x8080808080808080ull;
+
+    explicit hash_ctrl_group( uint8_t const* ctrl ) noexcept : word_( 0 )
+    {
+        for ( unsigned i = 0; i < WIDTH; ++i )
+            word_ |= uint64_t( ctrl[i] ) << ( i * 8 );
+    }
+
+    //! @brief      Bitmask of slots whose hash byte equals h2. May have false
+    //!             positives, which are filtered out by key comparison.
+    uint64_t match( uint8_t h2 ) const noexcept
+    {
+        uint64_t x = word_ ^ ( LSBS * h2 );
+        return ( x - LSBS ) & ~x & MSBS;
+    }
+
+    uint64_t match_empty() const noexcept
+    {
+        return word_ & ~( word_ << 6 ) & MSBS;
+    }
+
+    uint64_t match_empty_or_deleted() const noexcept
+    {
+        return word_ & ~( word_ << 7 ) & MSBS;
+    }
+
+    //! @brief      Get slot offset of the lowest bit of mask.
+    static unsigned offset( uint64_t mask ) noexcept
+    {
+        return bit_ctz64( mask ) / 8;
+    }
+
+private:
+    uint64_t word_;
+};
+} // namespace impl
+
+//! @brief      Open addressing hash map with fixed capacity.
+//! @details
+//!              Slots are probed in groups of 8 by quadratic probing over
+//!             groups; within a group, control bytes are matched at once with
+//!             SWAR word operations. Table keeps at most 7/8 of its slots
+//!             full, so probe sequences stay short. \n
+//!              Erased slots turn into tombstones unless their group has an
+//!             empty slot. Tombstones are reused by insertion, but under
+//!             constant churn they take over empty slots, and misses probe
+//!             longer. purge() rehashes in place to clear them, at a time of
+//!             caller's choice.
+//!              Pointers to values stay valid until the value is erased, or
+//!             the map is purged.
+//! @tparam cap__ Maximum number of elements.
+//! @tparam hash__ Hash function object returning 64 bit value.
+template <
+  typename key__,
+  typename value__,
+  size_t cap__,
+  typename hash__  = hash::hasher<key__>,
+  typename equal__ = std::equal_to<>>
+class static_hash_map
+{
+public:
+    using key_type    = key__;
+    using mapped_type = value__;
+    using size_type   = size_t;
+    using hasher      = hash__;
+    using key_equal   = equal__;
+
+    struct value_type
+    {
+        key_type const key;
+        mapped_type    value;
+    };
+
+private:
+    using group_type = impl::hash_ctrl_group;
+
+    static constexpr size_t table_size_()
+    {
+        size_t n = group_type::WIDTH;
+        while ( n - n / 8 < cap__ )
+            n <<= 1;
+        return n;
+    }
+
+public:
+    enum : size_t
+    {
+        TABLE_SIZE = table_size_(),
+        NUM_GROUPS = TABLE_SIZE / group_type::WIDTH
+    };
+
+public:
+    static_hash_map() noexcept
+    {
+        memset( ctrl_, group_type::EMPTY, sizeof ctrl_ );
+    }
+    ~static_hash_map() noexcept { clear(); }
+
+    static_hash_map( static_hash_map const& ) = delete;
+    static_hash_map& operator=( static_hash_map const& ) = delete;
+
+    size_type size() const noexcept { return size_; }
+    bool      empty() const noexcept { return size_ == 0; }
+    bool      full() const noexcept { return size_ == cap__; }
+
+    //! @brief      Get number of tombstones, which purge() would clear.
+    size_type tombstones() const noexcept { return deleted_; }
+
+    static constexpr size_type capacity() noexcept { return cap__; }
+
+    //! @returns    nullptr if there's no such key.
+    template <typename k__>
+    mapped_type* find( k__ const& key ) noexcept
+    {
+        size_t i = find_( key, hasher {}( key ) );
+        return i != NONE ? &slot_( i )->value : nullptr;
+    }
+
+    template <typename k__>
+    mapped_type const* find( k__ const& key ) const noexcept
+    {
+        return const_cast<static_hash_map*>( this )->find( key );
+    }
+
+    template <typename k__>
+    bool contains( k__ const& key ) const noexcept
+    {
+        return find( key ) != nullptr;
+    }
+
+    //! @brief      Insert value constructed from args, unless key exists.
+    //! @returns    Pointer to the value of the key, and whether it's inserted.
+    //!             Pointer is nullptr if the key is new but the map is full.
+    template <typename... arg_>
+    std::pair<mapped_type*, bool>
+    try_emplace( key_type const& key, arg_&&... args )
+    {
+        uint64_t h = hasher {}( key );
+        size_t   i = find_( key, h );
+        if ( i != NONE )
+            return { &slot_( i )->value, false };
+        if ( full() )
+            return { nullptr, false };
+
+        i = find_free_( h );
+        deleted_ -= ctrl_[i] == group_type::DELETED;
+        new ( slot_( i ) )
+          value_type { key, mapped_type( std::forward<arg_>( args )... ) };
+        ctrl_[i] = h2_( h );
+        ++size_;
+        return { &slot_( i )->value, true };
+    }
+
+    //! @brief      Insert or overwrite value of the key.
+    //! @returns    nullptr if the key is new but the map is full.
+    template <typename v__>
+    mapped_type* insert_or_assign( key_type const& key, v__&& value )
+    {
+        auto r = try_emplace( key, std::forward<v__>( value ) );
+        if ( r.first && !r.second )
+            *r.first = std::forward<v__>( value );
+        return r.first;
+    }
+
+    //! @returns    false if there's no such key.
+    template <typename k__>
+    bool erase( k__ const& key ) noexcept
+    {
+        size_t i = find_( key, hasher {}( key ) );
+        if ( i == NONE )
+            return false;
+
+        erase_at_( i );
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        if ( size_ )
+            for_each_slot_( [this]( size_t i ) { slot_( i )->~value_type(); } );
+        memset( ctrl_, group_type::EMPTY, sizeof ctrl_ );
+        size_    = 0;
+        deleted_ = 0;
+    }
+
+    //! @brief      Rehash every element in place, turning all tombstones into
+    //!             empty slots. O(TABLE_SIZE)
+    //! @details
+    //!              Elements may move, so pointers to values are invalidated.
+    //!             Nothing is allocated. Call it where a latency spike is
+    //!             acceptable, e.g. once tombstones() reaches 1/16 of
+    //!             TABLE_SIZE.
+    void purge() noexcept
+    {
+        // Tombstones become empty, and full slots are marked as deleted,
+        // which means 'not rehashed yet' below.
+        for ( size_t i = 0; i < TABLE_SIZE; ++i ) {
+            ctrl_[i] = ( ctrl_[i] & 0x80 ) ? uint8_t( group_type::EMPTY )
+                                           : uint8_t( group_type::DELETED );
+        }
+
+        for ( size_t i = 0; i < TABLE_SIZE; ++i ) {
+            if ( ctrl_[i] != group_type::DELETED )
+                continue;
+
+            uint64_t h  = hasher {}( slot_( i )->key );
+            size_t   to = find_free_( h );
+
+            // Already in the first group that has room.
+            if ( to / group_type::WIDTH == i / group_type::WIDTH ) {
+                ctrl_[i] = h2_( h );
+                continue;
+            }
+
+            if ( ctrl_[to] == group_type::EMPTY ) {
+                new ( slot_( to ) ) value_type( std::move( *slot_( i ) ) );
+                slot_( i )->~value_type();
+                ctrl_[to] = h2_( h );
+                ctrl_[i]  = group_type::EMPTY;
+            }
+            else {
+                // Swap with element not rehashed yet, then process it here.
+                swap_slots_( i, to );
+                ctrl_[to] = h2_( h );
+                --i;
+            }
+        }
+        deleted_ = 0;
+    }
+
+    //! @brief      Visit every element as fn( key, value ), in slot order.
+    //!             fn must not insert or erase.
+    template <typename fn__>
+    void for_each( fn__&& fn )
+    {
+        for_each_slot_( [&]( size_t i ) {
+            auto s = slot_( i );
+            fn( s->key, s->value );
+        } );
+    }
+
+private:
+    enum : size_t
+    {
+        NONE = size_t( -1 )
+    };
+
+    static size_t  h1_( uint64_t h ) noexcept { return size_t( h >> 7 ); }
+    static uint8_t h2_( uint64_t h ) noexcept { return uint8_t( h & 0x7f ); }
+
+    value_type* slot_( size_t i ) noexcept
+    {
+        return reinterpret_cast<value_type*>( slots_ ) + i;
+    }
+
+    //! Visits groups in triangular order, which covers every group once when
+    //! number of groups is power of 2.
+    struct probe_seq_
+    {
+        explicit probe_seq_( uint64_t h ) noexcept
+            : group_( h1_( h ) & ( NUM_GROUPS - 1 ) )
+            , step_( 0 )
+        {
+        }
+
+        size_t base() const noexcept { return group_ * group_type::WIDTH; }
+        bool   next() noexcept
+        {
+            group_ = ( group_ + ++step_ ) & ( NUM_GROUPS - 1 );
+            return step_ < NUM_GROUPS;
+        }
+
+    private:
+        size_t group_;
+        size_t step_;
+    };
+
+    template <typename k__>
+    size_t find_( k__ const& key, uint64_t h ) noexcept
+    {
+        uint8_t const h2 = h2_( h );
+        probe_seq_    seq( h );
+
+        do {
+            size_t     base = seq.base();
+            group_type grp( ctrl_ + base );
+
+            for ( auto m = grp.match( h2 ); m; m &= m - 1 ) {
+                size_t i = base + group_type::offset( m );
+                if ( ctrl_[i] == h2 && key_equal {}( slot_( i )->key, key ) )
+                    return i;
+            }
+
+            // Key would have been placed in this group.
+            if ( grp.match_empty() )
+                return NONE;
+        } while ( seq.next() );
+
+        return NONE;
+    }
+
+    size_t find_free_( uint64_t h ) const noexcept
+    {
+        probe_seq_ seq( h );
+        do {
+            auto m = group_type( ctrl_ + seq.base() ).match_empty_or_deleted();
+            if ( m )
+                return seq.base() + group_type::offset( m );
+        } while ( seq.next() );
+
+        uassert( false );
+        return NONE;
+    }
+
+    void erase_at_( size_t i ) noexcept
+    {
+        slot_( i )->~value_type();
+        --size_;
+
+        // If the group has an empty slot, no probe sequence continues past
+        // it, so the slot can be emptied instead of being a tombstone.
+        size_t base = i & ~size_t( group_type::WIDTH - 1 );
+        if ( group_type( ctrl_ + base ).match_empty() ) {
+            ctrl_[i] = group_type::EMPTY;
+        }
+        else {
+            ctrl_[i] = group_type::DELETED;
+            ++deleted_;
+        }
+    }
+
+    void swap_slots_( size_t a, size_t b ) noexcept
+    {
+        alignas( value_type ) unsigned char tmp[sizeof( value_type )];
+        auto t = new ( tmp ) value_type( std::move( *slot_( a ) ) );
+        slot_( a )->~value_type();
+        new ( slot_( a ) ) value_type( std::move( *slot_( b ) ) );
+        slot_( b )->~value_type();
+        new ( slot_( b ) ) value_type( std::move( *t ) );
+        t->~value_type();
+    }
+
+    template <typename fn__>
+    void for_each_slot_( fn__&& fn )
+    {
+        for ( size_t i = 0; i < TABLE_SIZE; ++i ) {
+            if ( ( ctrl_[i] & 0x80 ) == 0 )
+                fn( i );
+        }
+    }
+
+private:
+    alignas( value_type ) unsigned char slots_[sizeof( value_type )
+                                               * TABLE_SIZE];
+    uint8_t   ctrl_[TABLE_SIZE];
+    size_type size_    = 0;
+    size_type deleted_ = 0;
+};
+
+//! @}
+//! @}
+} // namespace upp
@@ -0,0 +1,159 @@
+//! @brief      Fixed capacity LRU cache
+//! @file       static_lru_cache.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             Least recently used cache which combines @ref upp::static_fslist
+//!             holding entries in recency order, with @ref upp::static_hash_map
+//!             indexing them by key. Nothing is allocated after construction.
+#pragma once
+#include <stdint.h>
+#include <type_traits>
+#include "static_fslist.hxx"
+#include "static_hash_map.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @weakgroup  uEmbedded_Cpp_HashMap
+//! @{
+
+//! @brief      LRU cache with O(1) get and put.
+//! @details
+//!              Entries are kept from the most recently used to the least. A
+//!             hit relinks the entry to the front without moving it; put()
+//!             into full cache evicts the back entry.
+template <
+  typename key__,
+  typename value__,
+  size_t cap__,
+  typename hash__ = hash::hasher<key__>>
+class static_lru_cache
+{
+public:
+    using key_type    = key__;
+    using mapped_type = value__;
+    using index_type
+      = std::conditional_t<( cap__ < 0xffff ), uint16_t, uint32_t>;
+
+    struct value_type
+    {
+        key_type    key;
+        mapped_type value;
+    };
+
+    using list_type      = static_fslist<value_type, index_type, cap__>;
+    using iterator       = typename list_type::iterator;
+    using const_iterator = typename list_type::const_iterator;
+
+    struct stats_type
+    {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+    };
+
+public:
+    size_t size() const noexcept { return list_.size(); }
+    bool   empty() const noexcept { return list_.empty(); }
+
+    static constexpr size_t capacity() noexcept { return cap__; }
+
+    //! @brief      Look up the key, and mark it as the most recently used.
+    //! @returns    nullptr on miss.
+    template <typename k__>
+    mapped_type* get( k__ const& key ) noexcept
+    {
+        auto idx = index_.find( key );
+        if ( idx == nullptr ) {
+            ++stats_.misses;
+            return nullptr;
+        }
+
+        ++stats_.hits;
+        auto it = list_.iter__( *idx );
+        list_.splice( list_.begin(), list_, it );
+        return &it->value;
+    }
+
+    //! @brief      Look up the key without touching recency or statistics.
+    template <typename k__>
+    mapped_type* peek( k__ const& key ) noexcept
+    {
+        auto idx = index_.find( key );
+        return idx ? &list_.at__( *idx )->value : nullptr;
+    }
+
+    //! @brief      Insert or overwrite value of the key, and mark it as the
+    //!             most recently used. Evicts the least recently used entry
+    //!             if the cache is full.
+    template <typename v__>
+    mapped_type& put( key_type const& key, v__&& value )
+    {
+        if ( auto idx = index_.find( key ) ) {
+            auto it   = list_.iter__( *idx );
+            it->value = std::forward<v__>( value );
+            list_.splice( list_.begin(), list_, it );
+            return it->value;
+        }
+
+        if ( list_.size() == cap__ ) {
+            index_.erase( list_.back().key );
+            list_.pop_back();
+            ++stats_.evictions;
+        }
+
+        auto& e = list_.emplace_front(
+          value_type { key, mapped_type( std::forward<v__>( value ) ) } );
+        index_.try_emplace( key, list_.begin().fs_idx__() );
+        return e.value;
+    }
+
+    //! @returns    false if there's no such key.
+    template <typename k__>
+    bool erase( k__ const& key ) noexcept
+    {
+        auto idx = index_.find( key );
+        if ( idx == nullptr )
+            return false;
+
+        list_.erase( list_.iter__( *idx ) );
+        index_.erase( key );
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        list_.clear();
+        index_.clear();
+    }
+
+    //! @brief      Clear tombstones of the key index. O(capacity)
+    //! @details
+    //!              Eviction churn leaves tombstones in the index, which make
+    //!             misses probe longer. Nothing is purged implicitly, so put()
+    //!             stays bounded; call this where a latency spike is
+    //!             acceptable. Entries don't move.
+    void   purge() noexcept { index_.purge(); }
+    size_t tombstones() const noexcept { return index_.tombstones(); }
+
+    stats_type const& stats() const noexcept { return stats_; }
+    void              reset_stats() noexcept { stats_ = {}; }
+
+    //! @brief      Iterate entries from the most recently used one.
+    iterator       begin() noexcept { return list_.begin(); }
+    iterator       end() noexcept { return list_.end(); }
+    const_iterator begin() const noexcept { return list_.cbegin(); }
+    const_iterator end() const noexcept { return list_.cend(); }
+
+private:
+    list_type                                            list_;
+    static_hash_map<key_type, index_type, cap__, hash__> index_;
+    stats_type                                           stats_ = {};
+};
+
+//! @}
+//! @}
+} // namespace upp
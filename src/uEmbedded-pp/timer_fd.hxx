@@ -0,0 +1,119 @@
+//! @brief      Tickless timerfd driver for upp::timer_logic
+//! @file       timer_fd.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             Drives @ref upp::timer_logic from an epoll loop with single
+//!             timerfd. The timer logic should read its tick from
+//!             @ref upp::monotonic_tick of the same duration, so that tick
+//!             values and timerfd deadlines share CLOCK_MONOTONIC. Linux only.
+#pragma once
+#ifdef __linux__
+#    include <chrono>
+#    include <stdint.h>
+#    include <time.h>
+#    include <unistd.h>
+#    include "../uEmbedded/timer_fd.h"
+#    include "timer_logic__.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @weakgroup  uEmbedded_Cpp_TimerLogic
+//! @{
+
+//! @brief      Tick source which reads CLOCK_MONOTONIC.
+//! @tparam duration__ Unit of a tick.
+template <typename duration__ = std::chrono::milliseconds>
+struct monotonic_tick
+{
+    auto operator()() const noexcept
+    {
+        timespec ts;
+        clock_gettime( CLOCK_MONOTONIC, &ts );
+        return std::chrono::duration_cast<duration__>(
+                 std::chrono::seconds( ts.tv_sec )
+                 + std::chrono::nanoseconds( ts.tv_nsec ) )
+          .count();
+    }
+};
+
+//! @brief      Arms timerfd to the next trigger time of timer logic.
+//! @details
+//!              Register fd() to epoll with EPOLLIN, and call dispatch() when
+//!             it becomes readable. Call sync() after adding or removing
+//!             timers outside of timer callbacks.
+//! @tparam timer_logic__ Any instance of @ref upp::timer_logic
+//! @tparam duration__ Unit of a timer tick.
+template <
+  typename timer_logic__,
+  typename duration__ = std::chrono::milliseconds>
+class timer_fd_driver
+{
+public:
+    using logic_type = timer_logic__;
+    using tick_type  = typename timer_logic__::tick_type;
+
+public:
+    explicit timer_fd_driver( logic_type& logic ) noexcept
+        : logic_( logic )
+    {
+        constexpr auto ns_per_tick
+          = std::chrono::duration_cast<std::chrono::nanoseconds>(
+              duration__( 1 ) )
+              .count();
+        static_assert( ns_per_tick > 0 && ns_per_tick <= UINT32_MAX );
+
+        timer_fd_init( &fd_, static_cast<uint32_t>( ns_per_tick ) );
+    }
+    ~timer_fd_driver() noexcept { timer_fd_destroy( &fd_ ); }
+
+    timer_fd_driver( timer_fd_driver const& ) = delete;
+    timer_fd_driver& operator=( timer_fd_driver const& ) = delete;
+
+    //! @brief      Check if timerfd was created.
+    bool valid() const noexcept { return fd_.fd >= 0; }
+    int  fd() const noexcept { return fd_.fd; }
+
+    //! @brief      Arm timerfd to @ref upp::timer_logic::next_trig()
+    //! @returns    false if timerfd_settime() failed, with errno set.
+    bool sync() noexcept { return arm_( logic_.next_trig() ); }
+
+    //! @brief      Consume expiration, update timer logic, then re-arm.
+    //! @param      next Optional output of
+    //!             @ref upp::timer_logic::next_trig()
+    //! @returns    false if timerfd could not be re-armed.
+    bool dispatch( tick_type* next = nullptr ) noexcept
+    {
+        uint64_t expirations;
+        if ( read( fd_.fd, &expirations, sizeof expirations ) > 0 )
+            fd_.armed = (size_t)-1;
+
+        auto next_trig = logic_.update();
+        if ( next )
+            *next = next_trig;
+        return arm_( next_trig );
+    }
+
+private:
+    bool arm_( tick_type next ) noexcept
+    {
+        return timer_fd_arm(
+          &fd_,
+          next == static_cast<tick_type>( TIMER_INVALID )
+            ? (size_t)-1
+            : static_cast<size_t>( next ) );
+    }
+
+private:
+    logic_type& logic_;
+    timer_fd_t  fd_;
+};
+
+//! @}
+//! @}
+} // namespace upp
+
+#endif
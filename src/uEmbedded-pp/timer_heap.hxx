@@ -0,0 +1,251 @@
+//! @brief      Indexed heap container for timer logic
+//! @file       timer_heap.hxx
+//!
+//! @author     Seungwoo Kang (ki6080@gmail.com)
+//! @copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+//!
+//! @details
+//!             A binary heap of timer descriptors, which can be used as the
+//!             container of @ref upp::timer_logic. Timers are stored in stable
+//!             slots, and the heap only holds the slot indexes with their keys.
+//!             Handles refer to the slot directly with a generation counter,
+//!             thus removal and lookup don't need any search.
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "../uEmbedded/uassert.h"
+#include "timer_logic__.hxx"
+
+namespace upp {
+//! @addtogroup uEmbedded_Cpp
+//! @{
+//! @weakgroup  uEmbedded_Cpp_TimerLogic
+//! @{
+
+namespace impl {
+
+//! @brief      Handle of the timer which is stored in indexed container.
+template <typename size_ty__>
+struct timer_slot_handle
+{
+    size_ty__ slot_;
+    size_ty__ gen_;
+};
+
+//! @brief      Stable storage of single timer.
+template <typename tick_ty__, typename size_ty__>
+struct timer_heap_slot
+{
+    timer_logic_desc<tick_ty__> desc_;
+    size_ty__                   heap_pos_;
+    size_ty__                   gen_;
+};
+
+//! @brief      Heap element. Caches the sort key to keep sift operations
+//!             inside the heap array.
+template <typename tick_ty__, typename size_ty__>
+struct timer_heap_entry
+{
+    tick_ty__ at_;
+    tick_ty__ id_;
+    size_ty__ slot_;
+};
+
+//! @brief      Indexed binary heap over caller provided arrays.
+//! @details
+//!              Timers are ordered by trigger time, then by id, thus timers
+//!             of the same trigger time expire in the order they were added.
+//!              Heap positions beyond the active count hold the released slot
+//!             indexes, and slots are taken lazily from a high-water mark, so
+//!             construction does not touch the arrays.
+template <typename tick_ty__, typename size_ty__>
+class timer_heap_base
+{
+public:
+    using desc_type   = timer_logic_desc<tick_ty__>;
+    using value_type  = desc_type;
+    using size_type   = size_ty__;
+    using handle_type = timer_slot_handle<size_ty__>;
+    using slot_type   = timer_heap_slot<tick_ty__, size_ty__>;
+    using entry_type  = timer_heap_entry<tick_ty__, size_ty__>;
+    enum
+    {
+        NODE_NONE = (size_type)-1
+    };
+
+    //! @brief      Marks this container as the one which provides indexed
+    //!             timer interfaces to @ref upp::timer_logic
+    using timer_index_tag = void;
+
+public:
+    timer_heap_base(
+      size_type   capacity,
+      slot_type*  slots,
+      entry_type* heap ) noexcept
+        : size_( 0 )
+        , hwm_( 0 )
+        , capacity_( capacity )
+        , slots_( slots )
+        , heap_( heap )
+    {
+    }
+
+    //! @brief      Insert new timer. O(log n)
+    handle_type push( desc_type const& d ) noexcept
+    {
+        uassert( size_ < capacity_ );
+        size_type slot;
+
+        // Recycle released slot first.
+        if ( size_ < hwm_ )
+            slot = heap_[size_].slot_;
+        else {
+            slot              = hwm_++;
+            slots_[slot].gen_ = 0;
+        }
+
+        auto& s = slots_[slot];
+        s.desc_ = d;
+
+        heap_[size_] = { d.trigger_at_, d.id_, slot };
+        sift_up_( size_++ );
+
+        return { slot, s.gen_ };
+    }
+
+    //! @brief      Find timer descriptor by handle. O(1)
+    desc_type const* find( handle_type const& h ) const noexcept
+    {
+        if ( h.slot_ >= hwm_ )
+            return nullptr;
+        auto& s = slots_[h.slot_];
+        return s.heap_pos_ != NODE_NONE && s.gen_ == h.gen_ ? &s.desc_
+                                                            : nullptr;
+    }
+
+    //! @brief      Remove timer by handle. O(log n)
+    bool erase( handle_type const& h ) noexcept
+    {
+        if ( find( h ) == nullptr )
+            return false;
+        remove_at_( slots_[h.slot_].heap_pos_ );
+        return true;
+    }
+
+    desc_type const& front() const noexcept
+    {
+        uassert( size_ );
+        return slots_[heap_[0].slot_].desc_;
+    }
+
+    void pop_front() noexcept
+    {
+        uassert( size_ );
+        remove_at_( 0 );
+    }
+
+    void clear() noexcept
+    {
+        for ( size_type i = 0; i < size_; ++i ) {
+            auto& s     = slots_[heap_[i].slot_];
+            s.heap_pos_ = NODE_NONE;
+            ++s.gen_;
+        }
+        size_ = 0;
+    }
+
+    size_type size() const noexcept { return size_; }
+    size_type max_size() const noexcept { return capacity_; }
+    bool      empty() const noexcept { return size_ == 0; }
+
+private:
+    static bool less_( entry_type const& a, entry_type const& b ) noexcept
+    {
+        return a.at_ < b.at_ || ( a.at_ == b.at_ && a.id_ < b.id_ );
+    }
+
+    void place_( size_type pos, entry_type const& e ) noexcept
+    {
+        heap_[pos]                = e;
+        slots_[e.slot_].heap_pos_ = pos;
+    }
+
+    void sift_up_( size_type pos ) noexcept
+    {
+        entry_type e = heap_[pos];
+        while ( pos ) {
+            size_type up = ( pos - 1 ) >> 1;
+            if ( !less_( e, heap_[up] ) )
+                break;
+            place_( pos, heap_[up] );
+            pos = up;
+        }
+        place_( pos, e );
+    }
+
+    void sift_down_( size_type pos ) noexcept
+    {
+        entry_type e = heap_[pos];
+        for ( ;; ) {
+            size_t child = ( size_t( pos ) << 1 ) + 1;
+            if ( child >= size_ )
+                break;
+            if ( child + 1 < size_ && less_( heap_[child + 1], heap_[child] ) )
+                ++child;
+            if ( !less_( heap_[child], e ) )
+                break;
+            place_( pos, heap_[child] );
+            pos = static_cast<size_type>( child );
+        }
+        place_( pos, e );
+    }
+
+    void remove_at_( size_type pos ) noexcept
+    {
+        size_type slot = heap_[pos].slot_;
+        auto&     s    = slots_[slot];
+
+        --size_;
+        if ( pos != size_ ) {
+            entry_type last = heap_[size_];
+            place_( pos, last );
+            if ( pos && less_( last, heap_[( pos - 1 ) >> 1] ) )
+                sift_up_( pos );
+            else
+                sift_down_( pos );
+        }
+
+        // Released slot is kept right after the active heap entries.
+        heap_[size_].slot_ = slot;
+        s.heap_pos_        = NODE_NONE;
+        ++s.gen_;
+    }
+
+private:
+    size_type   size_;
+    size_type   hwm_;
+    size_type   capacity_;
+    slot_type*  slots_;
+    entry_type* heap_;
+};
+
+} // namespace impl
+
+//! @brief      Indexed timer heap with static storage.
+template <typename tick_ty__, typename size_ty__, size_t cap__>
+class static_timer_heap : public impl::timer_heap_base<tick_ty__, size_ty__>
+{
+public:
+    using super = impl::timer_heap_base<tick_ty__, size_ty__>;
+
+public:
+    static_timer_heap() noexcept : super( cap__, slots_, heap_ ) { }
+
+private:
+    typename super::slot_type  slots_[cap__];
+    typename super::entry_type heap_[cap__];
+};
+
+//! @}
+//! @}
+} // namespace upp
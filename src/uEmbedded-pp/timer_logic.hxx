@@ -1,6 +1,7 @@
 #pragma once
 #include <list>
 #include "static_fslist.hxx"
+#include "timer_heap.hxx"
 #include "timer_logic__.hxx"
 
 namespace upp {
@@ -10,15 +11,36 @@ namespace upp {
 //! @{
 
 //! \brief      Simple aliasing for static timer logics
-template <typename tick_ty__, typename size_ty__, size_t num_tim__>
+template <
+    typename tick_ty__,
+    typename size_ty__,
+    size_t num_tim__,
+    typename tick_src__ = std::function<tick_ty__( void )>>
 using static_timer_logic = timer_logic<
     tick_ty__,
-    static_fslist<timer_logic_desc<tick_ty__>, size_ty__, num_tim__>>;
+    static_fslist<timer_logic_desc<tick_ty__>, size_ty__, num_tim__>,
+    tick_src__>;
+
+//! \brief      Static timer logic backed by indexed heap. Handles resolve to
+//!             the timer slot directly, thus remove() and browse() are O(1).
+template <
+    typename tick_ty__,
+    typename size_ty__,
+    size_t num_tim__,
+    typename tick_src__ = std::function<tick_ty__( void )>>
+using static_heap_timer_logic = timer_logic<
+    tick_ty__,
+    static_timer_heap<tick_ty__, size_ty__, num_tim__>,
+    tick_src__>;
 
 //! \brief      Simple aliasing for dynamic timer logics
-template <typename tick_ty__>
-using linked_timer_logic
-    = timer_logic<tick_ty__, std::list<timer_logic_desc<tick_ty__>>>;
+template <
+    typename tick_ty__,
+    typename tick_src__ = std::function<tick_ty__( void )>>
+using linked_timer_logic = timer_logic<
+    tick_ty__,
+    std::list<timer_logic_desc<tick_ty__>>,
+    tick_src__>;
 //! @}
 //! @}
 } // namespace upp
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <stdint.h>
+#include <type_traits>
 #include "../uEmbedded/uassert.h"
 namespace upp {
 //! @addtogroup uEmbedded_Cpp
@@ -36,6 +38,61 @@ struct timer_logic_desc
     timer_cb_t cb_;
 };
 
+namespace impl {
+
+//! @brief      Selects timer handle type and lookup strategy of container.
+//! @details
+//!              List containers are kept sorted by insertion, and looked up by
+//!             linear search. Containers which declare timer_index_tag provide
+//!             their own handle type, and push(), erase() and find() methods
+//!             that operate on it directly. e.g. @ref upp::static_timer_heap
+template <typename tick_ty__, typename container__, typename = void>
+struct timer_container_traits
+{
+    using handle_type = timer_handle<tick_ty__>;
+
+    static constexpr bool is_indexed = false;
+};
+
+template <typename tick_ty__, typename container__>
+struct timer_container_traits<
+  tick_ty__,
+  container__,
+  typename container__::timer_index_tag>
+{
+    using handle_type = typename container__::handle_type;
+
+    static constexpr bool is_indexed = true;
+};
+
+//! @brief      Checks if tick source is callable. Only the sources which can
+//!             be tested as bool, e.g. std::function or function pointer, can
+//!             be empty.
+template <typename tick_src__>
+bool tick_source_valid( tick_src__ const& src ) noexcept
+{
+    if constexpr ( std::is_constructible_v<bool, tick_src__ const&> )
+        return static_cast<bool>( src );
+    else
+        return true;
+}
+
+} // namespace impl
+
+//! @brief      Tick source which reads std::chrono clock.
+//! @tparam clock__ e.g. std::chrono::steady_clock
+//! @tparam duration__ Unit of a tick.
+template <typename clock__, typename duration__ = typename clock__::duration>
+struct clock_tick
+{
+    auto operator()() const noexcept
+    {
+        return std::chrono::duration_cast<duration__>(
+                 clock__::now().time_since_epoch() )
+          .count();
+    }
+};
+
 //! @brief      Logical timer management class
 //! @details
 //!              Regardless of hardware, it abstracts timer behavior logically.
@@ -58,18 +115,37 @@ struct timer_logic_desc
 //!              e.g. std::list<upp::impl::timer_logic_desc<tick_t>> \n
 //!              Because the timer uses only the standard list interface
 //!             internally, you can flexibly use any data structure that
-//!             supports the insert() function.
-template <typename tick_ty__, typename list_container__>
+//!             supports the insert() function. \n
+//!              Indexed containers such as @ref upp::static_timer_heap are
+//!             also accepted. Then add() costs O(log n), and remove() and
+//!             browse() resolve handles in O(1).
+//! @tparam tick_src__
+//!              Callable type which returns current tick. Default is
+//!             std::function, which can be replaced at runtime. A functor type
+//!             such as @ref upp::clock_tick lets the compiler inline the tick
+//!             read.
+template <
+  typename tick_ty__,
+  typename list_container__,
+  typename tick_src__ = std::function<tick_ty__( void )>>
 class timer_logic
 {
 public:
     using desc_type      = timer_logic_desc<tick_ty__>;
     using tick_type      = tick_ty__;
-    using tick_fnc_type  = std::function<tick_type( void )>;
+    using tick_fnc_type  = tick_src__;
     using container_type = list_container__;
-    using handle_type    = impl::timer_handle<tick_ty__>;
+    using traits_type
+      = impl::timer_container_traits<tick_ty__, list_container__>;
+    using handle_type    = typename traits_type::handle_type;
 
 public:
+    timer_logic() = default;
+    explicit timer_logic( tick_fnc_type tick ) noexcept
+        : tick_( std::move( tick ) )
+    {
+    }
+
     tick_fnc_type const& tick_function() const noexcept { return tick_; }
     template <class tick_fnc__>
     void tick_function( tick_fnc__&& v ) noexcept
@@ -89,7 +165,7 @@ public:
     handle_type add( tick_type delay, void* obj, timer_cb_t callback ) noexcept
     {
         uassert( is_updating_ == false );
-        uassert( tick_ );
+        uassert( impl::tick_source_valid( tick_ ) );
         uassert( capacity() );
 
         desc_type d;
@@ -98,29 +174,40 @@ public:
         d.obj_        = obj;
         d.id_         = id_gen_++;
 
-        auto at = std::find_if( node_.begin(), node_.end(), [&d]( auto& a ) {
-            return d.trigger_at_ < a.trigger_at_;
-        } );
+        if constexpr ( traits_type::is_indexed ) {
+            return node_.push( d );
+        }
+        else {
+            auto at
+              = std::find_if( node_.begin(), node_.end(), [&d]( auto& a ) {
+                    return d.trigger_at_ < a.trigger_at_;
+                } );
 
-        node_.insert( at, d );
+            node_.insert( at, d );
 
-        handle_type ret;
-        ret.id_   = d.id_;
-        ret.time_ = d.trigger_at_;
-        return ret;
+            handle_type ret;
+            ret.id_   = d.id_;
+            ret.time_ = d.trigger_at_;
+            return ret;
+        }
     }
 
     //! @brief      Removes allocated timer.
     bool remove( handle_type const& t ) noexcept
     {
         uassert( is_updating_ == false );
-        auto it = find_( t );
-        if ( it != node_.end() ) {
-            node_.erase( it );
-            return true;
+        if constexpr ( traits_type::is_indexed ) {
+            return node_.erase( t );
         }
         else {
-            return false;
+            auto it = find_( t );
+            if ( it != node_.end() ) {
+                node_.erase( it );
+                return true;
+            }
+            else {
+                return false;
+            }
         }
     }
 
@@ -141,18 +228,29 @@ public:
     //! @returns true if given timer node is valid.
     bool browse( handle_type const& t, desc_type& out ) const noexcept
     {
-        auto it = find_( t );
-        if ( it == node_.cend() ) {
-            return false;
+        if constexpr ( traits_type::is_indexed ) {
+            auto p = node_.find( t );
+            if ( p == nullptr ) {
+                return false;
+            }
+            out = *p;
+            return true;
+        }
+        else {
+            auto it = find_( t );
+            if ( it == node_.cend() ) {
+                return false;
+            }
+            out = *it;
+            return true;
         }
-        out = *it;
-        return true;
     }
 
     //! @brief      Update timer.
     //! @details
     //!              It compares sequentially with the time returned by
-    //!             tick_function from the front of the active timer node. \n
+    //!             tick_function from the front of the active timer node. The
+    //!             tick is sampled once per update. \n
     //!              The timer node is always sorted, so even after performing
     //!             an update, the timer node is always sorted. \n
     //!              Also, it always performs a comparison with the frontmost
@@ -165,11 +263,10 @@ public:
     //! \{
     tick_type update() noexcept
     {
-        for ( auto it = node_.begin();
-              it != node_.end() && it->trigger_at_ <= tick_();
-              it = node_.begin() ) {
-            auto cb  = it->cb_;
-            auto obj = it->obj_;
+        auto const now = tick_();
+        while ( !node_.empty() && node_.front().trigger_at_ <= now ) {
+            auto cb  = node_.front().cb_;
+            auto obj = node_.front().obj_;
 
             node_.pop_front();
             cb( obj );
@@ -181,19 +278,20 @@ public:
     tick_type
     update_lock( callable_lock__&& lock, callable_unlock__&& unlock ) noexcept
     {
-        typename container_type::const_iterator it;
+        tick_type now {};
 
-        for ( ;; ) {
+        for ( bool first = true;; first = false ) {
             lock();
             is_updating_ = true;
-            it           = node_.begin();
-            if ( it == node_.end() || it->trigger_at_ > tick_() ) {
+            if ( first )
+                now = tick_();
+            if ( node_.empty() || node_.front().trigger_at_ > now ) {
                 unlock();
                 break;
             }
 
-            auto cb  = it->cb_;
-            auto obj = it->obj_;
+            auto cb  = node_.front().cb_;
+            auto obj = node_.front().obj_;
 
             node_.pop_front();
             is_updating_ = false;
@@ -207,6 +305,72 @@ public:
     }
     //! \}
 
+    //! @brief      Update timer, collecting expired timers in batch.
+    //! @details
+    //!              Samples tick_function once per call. Each pass takes the
+    //!             lock once, and moves every timer due at that tick into the
+    //!             scratch buffer, up to its capacity. Callbacks are invoked in
+    //!             trigger order after unlock, so they can add new timers.
+    //!             Passes repeat until nothing is collected, therefore timers
+    //!             added from callbacks which are due at the sampled tick also
+    //!             fire in this call. Timers that become due later, while
+    //!             callbacks run, are left for the next call.
+    //! @note
+    //!              Collected timers are no longer in the container. A callback
+    //!             can't cancel another timer of the same batch with remove().
+    //! @param scratch
+    //!              Caller-supplied buffer for expired timer descriptors.
+    //! @returns @ref next_trig()
+    //! \{
+    template <class callable_lock__, class callable_unlock__>
+    tick_type update_batch_lock(
+      callable_lock__&&   lock,
+      callable_unlock__&& unlock,
+      desc_type*          scratch,
+      size_t              scratch_size ) noexcept
+    {
+        uassert( scratch && scratch_size );
+        auto const now = tick_();
+
+        for ( ;; ) {
+            size_t num_due = 0;
+
+            lock();
+            is_updating_ = true;
+            while ( num_due < scratch_size && !node_.empty()
+                    && node_.front().trigger_at_ <= now ) {
+                scratch[num_due++] = node_.front();
+                node_.pop_front();
+            }
+            is_updating_ = false;
+            unlock();
+
+            if ( num_due == 0 )
+                break;
+
+            for ( size_t i = 0; i < num_due; ++i )
+                scratch[i].cb_( scratch[i].obj_ );
+        }
+
+        return next_trig();
+    }
+    template <
+      size_t batch__ = 64,
+      class callable_lock__,
+      class callable_unlock__>
+    tick_type update_batch_lock(
+      callable_lock__&&   lock,
+      callable_unlock__&& unlock ) noexcept
+    {
+        desc_type scratch[batch__];
+        return update_batch_lock(
+          std::forward<callable_lock__>( lock ),
+          std::forward<callable_unlock__>( unlock ),
+          scratch,
+          batch__ );
+    }
+    //! \}
+
     //! @brief      Clear all timer instances
     void clear() noexcept { node_.clear(); }
 
@@ -220,7 +384,7 @@ public:
     bool empty() const noexcept { return node_.empty(); }
 
 private:
-    typename container_type::const_iterator find_( handle_type const& h ) const
+    auto find_( handle_type const& h ) const
     {
         auto       beg = node_.cbegin();
         auto const end = node_.cend();
@@ -6,7 +6,13 @@
 #    include <optional>
 #endif
 
+#include <functional>
+#include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
 namespace upp {
 namespace hash {
 
@@ -54,6 +60,74 @@ inline const uint32_t fnv1a_32( const void* key )
 
     return hash;
 }
+
+//! @brief      FNV1a 64 bit hash of arbitrary bytes.
+inline uint64_t fnv1a_64_bytes(
+  void const* data,
+  size_t      size,
+  uint64_t    value = val_64_const ) noexcept
+{
+    auto p = static_cast<unsigned char const*>( data );
+    for ( size_t i = 0; i < size; ++i )
+        value = ( value ^ p[i] ) * prime_64_const;
+    return value;
+}
+
+//! @brief      Finalizer of MurmurHash3. Spreads every input bit over the
+//!             whole word, thus both upper and lower bits are usable.
+inline constexpr uint64_t mix_64( uint64_t k ) noexcept
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return k;
+}
+
+//! @brief      Default hasher of uEmbedded-pp hash containers.
+//! @details
+//!              Integral and enum keys are mixed with mix_64(), and string
+//!             keys are hashed with fnv1a_64_bytes(). Other types fall back
+//!             to std::hash, whose result is mixed as well.
+template <typename key__, typename = void>
+struct hasher
+{
+    uint64_t operator()( key__ const& k ) const noexcept
+    {
+        return mix_64( std::hash<key__> {}( k ) );
+    }
+};
+
+template <typename key__>
+struct hasher<
+  key__,
+  std::enable_if_t<std::is_integral_v<key__> || std::is_enum_v<key__>>>
+{
+    uint64_t operator()( key__ k ) const noexcept
+    {
+        return mix_64( static_cast<uint64_t>( k ) );
+    }
+};
+
+template <>
+struct hasher<std::string_view>
+{
+    uint64_t operator()( std::string_view k ) const noexcept
+    {
+        return fnv1a_64_bytes( k.data(), k.size() );
+    }
+};
+
+template <>
+struct hasher<std::string> : hasher<std::string_view>
+{
+};
+
+template <>
+struct hasher<char const*> : hasher<std::string_view>
+{
+};
 } // namespace hash
 
 namespace binutil {
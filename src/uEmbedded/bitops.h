@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+#if defined( _MSC_VER )
+#    include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! @addtogroup uEmbedded_C
+//! @{
+//! @defgroup   uEmbedded_C_BitOps
+//! @brief      Portable bit scanning helpers
+//! @{
+
+//! \brief      Count leading zero bits of 64-bit word. Result of 0 is 64.
+static inline unsigned bit_clz64( uint64_t v )
+{
+    if ( v == 0 )
+        return 64;
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return (unsigned)__builtin_clzll( v );
+#elif defined( _MSC_VER ) && defined( _WIN64 )
+    unsigned long idx;
+    _BitScanReverse64( &idx, v );
+    return 63 - (unsigned)idx;
+#else
+    unsigned n = 0;
+    while ( ( v & ( (uint64_t)1 << 63 ) ) == 0 ) {
+        v <<= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+//! \brief      Count trailing zero bits of 64-bit word. Result of 0 is 64.
+static inline unsigned bit_ctz64( uint64_t v )
+{
+    if ( v == 0 )
+        return 64;
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return (unsigned)__builtin_ctzll( v );
+#elif defined( _MSC_VER ) && defined( _WIN64 )
+    unsigned long idx;
+    _BitScanForward64( &idx, v );
+    return (unsigned)idx;
+#else
+    unsigned n = 0;
+    while ( ( v & 1 ) == 0 ) {
+        v >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+//! \brief      Number of significant bits. 0 for 0, 64 for values >= 2^63
+static inline unsigned bit_width64( uint64_t v )
+{
+    return 64 - bit_clz64( v );
+}
+
+//! @}
+//! @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,235 @@
+#include "concurrent_reference_pool.h"
+#include "fslist_cpool.h"
+#include "uassert.h"
+
+#ifndef __STDC_NO_ATOMICS__
+#    include <stdatomic.h>
+
+// Slot state word: generation on upper 32 bits, then pending free flag and pin
+// count. Free slot keeps the flag set, so it can never be locked.
+#    define STATE_PENDING ( (uint_least64_t)1 << 31 )
+#    define STATE_PINS ( STATE_PENDING - 1 )
+#    define STATE_GEN( st ) ( (uint32_t)( ( st ) >> 32 ) )
+
+enum
+{
+    CACHE_LINE = 64
+};
+
+struct cref_slot
+{
+    atomic_uint_least64_t state;
+    void*                 ref;
+};
+
+struct concurrent_reference_pool
+{
+    fslist_cpool_t* freeSlots;
+    allocator_ref_t alloc;
+    uint32_t        capacity;
+    char            pad[CACHE_LINE];
+
+    atomic_size_t numAlive;
+    char          pad1[CACHE_LINE];
+
+    struct cref_slot* slots;
+};
+
+concurrent_reference_pool_t*
+crefpool_create( size_t numMaxRef, allocator_ref_t alloc )
+{
+    concurrent_reference_pool_t* s;
+    size_t                       i;
+
+    uassert( numMaxRef < (uint32_t)CREF_SLOT_NONE );
+
+    s = malloc( sizeof( concurrent_reference_pool_t ) );
+    if ( s == NULL )
+        return NULL;
+
+    s->freeSlots = fslist_cpool_create( (uint32_t)numMaxRef );
+    s->slots = malloc( ( numMaxRef ? numMaxRef : 1 ) * sizeof *s->slots );
+    if ( s->freeSlots == NULL || s->slots == NULL ) {
+        if ( s->freeSlots )
+            fslist_cpool_destroy( s->freeSlots );
+        free( s->slots );
+        free( s );
+        return NULL;
+    }
+
+    s->alloc    = alloc ? alloc : &g_mallocator;
+    s->capacity = (uint32_t)numMaxRef;
+    atomic_init( &s->numAlive, 0 );
+    for ( i = 0; i < numMaxRef; ++i ) {
+        atomic_init( &s->slots[i].state, STATE_PENDING );
+        s->slots[i].ref = NULL;
+    }
+    return s;
+}
+
+static void slot_reclaim( concurrent_reference_pool_t* s, uint32_t slot )
+{
+    // Pending with no pin; nobody else can reach the object any more.
+    s->alloc->release( s->alloc->object, s->slots[slot].ref );
+    s->slots[slot].ref = NULL;
+
+    atomic_fetch_sub_explicit( &s->numAlive, 1, memory_order_relaxed );
+    fslist_cpool_push( s->freeSlots, slot );
+}
+
+void crefpool_destroy( concurrent_reference_pool_t* s )
+{
+    uint32_t i;
+
+    for ( i = 0; i < s->capacity; ++i ) {
+        if ( s->slots[i].ref )
+            s->alloc->release( s->alloc->object, s->slots[i].ref );
+    }
+
+    fslist_cpool_destroy( s->freeSlots );
+    free( s->slots );
+    free( s );
+}
+
+crefhandle_t crefpool_malloc( concurrent_reference_pool_t* s, size_t memsize )
+{
+    crefhandle_t      ret;
+    struct cref_slot* sl;
+    uint32_t          slot, gen;
+
+    ret.s    = s;
+    ret.slot = (uint32_t)CREF_SLOT_NONE;
+    ret.gen  = 0;
+
+    slot = fslist_cpool_pop( s->freeSlots );
+    if ( slot == (uint32_t)FSLIST_CPOOL_NONE )
+        return ret;
+
+    sl      = &s->slots[slot];
+    sl->ref = s->alloc->allocate( s->alloc->object, memsize );
+    if ( sl->ref == NULL ) {
+        fslist_cpool_push( s->freeSlots, slot );
+        return ret;
+    }
+
+    // Generation 0 is never handed out.
+    gen = STATE_GEN(
+              atomic_load_explicit( &sl->state, memory_order_relaxed ) )
+          + 1;
+    gen += gen == 0;
+
+    // Publishes ref along with the new generation.
+    atomic_store_explicit(
+        &sl->state, (uint_least64_t)gen << 32, memory_order_release );
+    atomic_fetch_add_explicit( &s->numAlive, 1, memory_order_relaxed );
+
+    ret.slot = slot;
+    ret.gen  = gen;
+    return ret;
+}
+
+size_t crefpool_num_available( concurrent_reference_pool_t const* s )
+{
+    return s->capacity
+           - atomic_load_explicit(
+               (atomic_size_t*)&s->numAlive, memory_order_relaxed );
+}
+
+void crefpool_foreach(
+    concurrent_reference_pool_t* s,
+    void*                        caller,
+    crefpool_foreach_callback_t  cb )
+{
+    crefhandle_t   h;
+    uint_least64_t st;
+
+    uassert( s && cb );
+    h.s = s;
+
+    for ( h.slot = 0; h.slot < s->capacity; ++h.slot ) {
+        st = atomic_load_explicit(
+            &s->slots[h.slot].state, memory_order_relaxed );
+        if ( st & STATE_PENDING )
+            continue;
+
+        h.gen = STATE_GEN( st );
+        if ( cref_lock( &h ) ) {
+            cb( caller, &h );
+            cref_unlock( &h );
+        }
+    }
+}
+
+void* cref_lock( crefhandle_t const* h )
+{
+    struct cref_slot* sl;
+    uint_least64_t    st;
+
+    uassert( h->s );
+    if ( h->slot >= h->s->capacity )
+        return NULL;
+
+    sl = &h->s->slots[h->slot];
+    st = atomic_load_explicit( &sl->state, memory_order_acquire );
+    do {
+        if ( STATE_GEN( st ) != h->gen || ( st & STATE_PENDING ) )
+            return NULL;
+    } while ( !atomic_compare_exchange_weak_explicit(
+        &sl->state, &st, st + 1, memory_order_acquire, memory_order_acquire ) );
+
+    return sl->ref;
+}
+
+void cref_unlock( crefhandle_t const* h )
+{
+    uint_least64_t st;
+
+    uassert( h->s && h->slot < h->s->capacity );
+    st = atomic_fetch_sub_explicit(
+        &h->s->slots[h->slot].state, 1, memory_order_acq_rel );
+    uassert( STATE_GEN( st ) == h->gen && ( st & STATE_PINS ) );
+
+    if ( ( st & STATE_PENDING ) && ( st & STATE_PINS ) == 1 )
+        slot_reclaim( h->s, h->slot );
+}
+
+bool cref_free( crefhandle_t const* h )
+{
+    struct cref_slot* sl;
+    uint_least64_t    st;
+
+    uassert( h->s );
+    if ( h->slot >= h->s->capacity )
+        return false;
+
+    sl = &h->s->slots[h->slot];
+    st = atomic_load_explicit( &sl->state, memory_order_relaxed );
+    do {
+        if ( STATE_GEN( st ) != h->gen || ( st & STATE_PENDING ) )
+            return false;
+    } while ( !atomic_compare_exchange_weak_explicit(
+        &sl->state,
+        &st,
+        st | STATE_PENDING,
+        memory_order_acq_rel,
+        memory_order_relaxed ) );
+
+    if ( ( st & STATE_PINS ) == 0 )
+        slot_reclaim( h->s, h->slot );
+    return true;
+}
+
+bool cref_is_valid( crefhandle_t const* h )
+{
+    uint_least64_t st;
+
+    uassert( h->s );
+    if ( h->slot >= h->s->capacity )
+        return false;
+
+    st = atomic_load_explicit(
+        &h->s->slots[h->slot].state, memory_order_acquire );
+    return STATE_GEN( st ) == h->gen && ( st & STATE_PENDING ) == 0;
+}
+
+#endif
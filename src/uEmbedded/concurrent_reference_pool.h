@@ -0,0 +1,88 @@
+/*! \brief      Thread-safe managed reference pool
+    \file       concurrent_reference_pool.h
+    \author     Seungwoo Kang (ki6080@gmail.com)
+    \copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+
+    \details
+      Concurrent counterpart of managed_reference_pool. Handles can be shared
+      between any number of threads. Each slot has single atomic state word
+      packing its generation, pending free flag, and pin count, thus checking a
+      handle is single acquire load, and locking it is single CAS on the slot.
+      No operation takes a lock.
+      Freeing pinned object only marks it; the pin count works as hazard of
+      the object, and whoever drops the last pin reclaims it. Free slots are
+      recycled through fslist_cpool.
+      Requires C11 atomics.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "allocator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+    CREF_SLOT_NONE = -1
+};
+
+typedef struct concurrent_reference_pool concurrent_reference_pool_t;
+
+typedef struct crefhandle
+{
+    concurrent_reference_pool_t* s;
+    uint32_t                     slot;
+    uint32_t                     gen;
+} crefhandle_t;
+
+/*! \brief      Create pool of up to numMaxRef objects.
+    \param alloc Allocator of objects, which must be thread-safe. NULL to use
+                \ref g_mallocator.
+    \returns    NULL on allocation failure. */
+concurrent_reference_pool_t*
+crefpool_create( size_t numMaxRef, allocator_ref_t alloc );
+
+/*! \warning    No other thread may access the pool during destruction. Every
+                object still alive is released. */
+void crefpool_destroy( concurrent_reference_pool_t* s );
+
+/*! \brief      Allocate new object. Thread-safe.
+    \returns    Handle with slot CREF_SLOT_NONE if the pool is full, or the
+                allocator failed. */
+crefhandle_t crefpool_malloc( concurrent_reference_pool_t* s, size_t memsize );
+
+size_t crefpool_num_available( concurrent_reference_pool_t const* s );
+
+typedef void ( *crefpool_foreach_callback_t )(
+    void* /*caller*/,
+    crefhandle_t const* /*iter_object*/ );
+
+/*! \brief      Visit every alive object in slot order, keeping it locked
+                during callback. Thread-safe. Objects allocated or freed
+                concurrently may or may not be visited. */
+void crefpool_foreach(
+    concurrent_reference_pool_t* s,
+    void*                        caller,
+    crefpool_foreach_callback_t  cb );
+
+/*! \brief      Pin the object, which defers its release until unlocked.
+    \returns    NULL if the handle is stale, or the object is being freed. */
+void* cref_lock( crefhandle_t const* h );
+
+/*! \brief      Unpin the object. Releases it if it was freed meanwhile, and
+                this was the last pin. */
+void cref_unlock( crefhandle_t const* h );
+
+/*! \brief      Invalidate the handle. Object is released immediately if it's
+                not pinned, otherwise by the last unlock.
+    \returns    false if the handle was already stale, or freed. */
+bool cref_free( crefhandle_t const* h );
+
+bool cref_is_valid( crefhandle_t const* h );
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,62 +3,194 @@
 #include <string.h>
 #include "uassert.h"
 
-typedef struct node
+enum
+{
+    SLOT_NONE = -1u
+};
+
+typedef struct subscription
 {
-    struct node*        next;
     refhandle_t         objref;
-    delegate_event_cb_t cb;
-} node_t;
+    delegate_event_cb_t cb; // NULL marks tombstone.
+    uint32_t            slot;
+} sub_t;
+
+//! Stable identity of a subscription, which maps its handle to position.
+typedef struct slot
+{
+    uint32_t gen;
+    uint32_t pos; // Next free slot, while the slot is free.
+} slot_t;
 
 struct delegate
 {
-    node_t* head;
-    size_t  cnt;
-    bool    bMulticast;
-    bool    bEraseLock;
+    sub_t*   subs;  // Points inlineSubs until it outgrows them.
+    slot_t*  slots; // Same capacity as subs.
+    size_t   len;   // Number of entries in use, including tombstones.
+    size_t   cap;
+    size_t   cnt;
+    size_t   numTombs;
+    uint32_t slotHwm;
+    uint32_t freeSlot;
+    int      callDepth;
+    bool     bMulticast;
+    sub_t    inlineSubs[DELEGATE_INLINE_SUBS];
+    slot_t   inlineSlots[DELEGATE_INLINE_SUBS];
 };
 
-void delegate_assign(
+// Squeeze tombstones out, keeping order of subscriptions.
+static void compact( delegate_t* s )
+{
+    size_t i, n = 0;
+
+    for ( i = 0; i < s->len; ++i ) {
+        if ( s->subs[i].cb ) {
+            s->slots[s->subs[i].slot].pos = (uint32_t)n;
+            s->subs[n++]                  = s->subs[i];
+        }
+    }
+    s->len      = n;
+    s->numTombs = 0;
+}
+
+static uint32_t slot_alloc( delegate_t* s, uint32_t pos )
+{
+    uint32_t slot = s->freeSlot;
+
+    if ( slot != SLOT_NONE ) {
+        s->freeSlot = s->slots[slot].pos;
+    }
+    else {
+        slot               = s->slotHwm++;
+        s->slots[slot].gen = 1;
+    }
+
+    s->slots[slot].pos = pos;
+    return slot;
+}
+
+static void slot_release( delegate_t* s, uint32_t slot )
+{
+    // Generation 0 is never handed out.
+    if ( ++s->slots[slot].gen == 0 )
+        s->slots[slot].gen = 1;
+    s->slots[slot].pos = s->freeSlot;
+    s->freeSlot        = slot;
+}
+
+static delegate_handle_t handle_of( delegate_t const* s, uint32_t slot )
+{
+    return (uint64_t)s->slots[slot].gen << 32 | slot;
+}
+
+static void tombstone( delegate_t* s, sub_t* sub )
+{
+    slot_release( s, sub->slot );
+    sub->cb = NULL;
+    ++s->numTombs;
+    --s->cnt;
+}
+
+// Tombstones can't be moved during call; otherwise they're purged once they
+// fill half of the array, which is amortized O(1) per removal.
+static void maybe_compact( delegate_t* s )
+{
+    if ( s->callDepth == 0 && s->numTombs && s->numTombs * 2 >= s->len )
+        compact( s );
+}
+
+static bool reserve( delegate_t* s )
+{
+    sub_t*  subs;
+    slot_t* slots;
+    size_t  cap;
+
+    if ( s->len < s->cap )
+        return true;
+
+    // Reuse tombstones first, unless a call is sweeping the array.
+    if ( s->callDepth == 0 && s->numTombs ) {
+        compact( s );
+        return true;
+    }
+
+    cap = s->cap * 2;
+    if ( s->subs == s->inlineSubs ) {
+        subs  = malloc( cap * sizeof( sub_t ) );
+        slots = malloc( cap * sizeof( slot_t ) );
+        if ( subs == NULL || slots == NULL ) {
+            free( subs );
+            free( slots );
+            return false;
+        }
+        memcpy( subs, s->subs, s->len * sizeof( sub_t ) );
+        memcpy( slots, s->slots, s->slotHwm * sizeof( slot_t ) );
+    }
+    else {
+        subs = realloc( s->subs, cap * sizeof( sub_t ) );
+        if ( subs == NULL )
+            return false;
+        s->subs = subs;
+
+        slots = realloc( s->slots, cap * sizeof( slot_t ) );
+        if ( slots == NULL )
+            return false;
+    }
+
+    // Slots never used are initialized as they're taken.
+    s->subs  = subs;
+    s->slots = slots;
+    s->cap   = cap;
+    return true;
+}
+
+delegate_handle_t delegate_assign(
     delegate_t*         s,
     refhandle_t const*  objref,
     delegate_event_cb_t callback )
 {
+    sub_t* sub;
+
     uassert( s && callback && objref );
 
-    if ( s->bMulticast ) {
-        node_t* newNode;
-        newNode       = malloc( sizeof( node_t ) );
-        newNode->next = s->head;
-        s->head       = newNode;
-        ++s->cnt;
+    if ( s->bMulticast || s->len == 0 ) {
+        if ( reserve( s ) == false ) {
+            uassert( false );
+            return DELEGATE_HANDLE_NONE;
+        }
+        sub = &s->subs[s->len++];
     }
-    else if ( s->head == NULL ) {
-        s->head = malloc( sizeof( node_t ) );
-        s->cnt  = 1;
+    else {
+        // Single cast delegate overwrites its only subscription, which
+        // invalidates handle of the previous one.
+        sub = &s->subs[0];
+        if ( sub->cb )
+            tombstone( s, sub );
+        --s->numTombs;
     }
 
-    s->head->objref = *objref;
-    s->head->cb     = callback;
+    ++s->cnt;
+    sub->objref = *objref;
+    sub->cb     = callback;
+    sub->slot   = slot_alloc( s, ( uint32_t )( sub - s->subs ) );
+    return handle_of( s, sub->slot );
 }
 
 void delegate_clear( delegate_t* s )
 {
+    size_t i;
+
     uassert( s );
-    node_t* head = s->head;
-    node_t* next;
-    int     bEraseLock = s->bEraseLock;
-
-    for ( ; head; head = next ) {
-        next = head->next;
-        if ( bEraseLock )
-            head->cb = NULL;
-        else
-            free( head );
+    for ( i = 0; i < s->len; ++i ) {
+        if ( s->subs[i].cb )
+            tombstone( s, &s->subs[i] );
     }
-    s->cnt = 0;
 
-    if ( bEraseLock == false )
-        s->head = NULL;
+    // Slots are kept, since their generations must outlive handles.
+    if ( s->callDepth == 0 ) {
+        s->len      = 0;
+        s->numTombs = 0;
+    }
 }
 
 size_t delegate_size( delegate_t* s )
@@ -71,94 +203,93 @@ size_t delegate_delete(
     refhandle_t const*  objref,
     delegate_event_cb_t callback )
 {
+    size_t i;
+    size_t numDelete = 0;
+
     uassert( s && objref );
-    node_t* head = s->head;
-    node_t* prev = NULL;
-    node_t* next;
-    int     bMulticast = s->bMulticast;
-    int     bEraseLock = s->bEraseLock;
-    size_t  numDelete  = 0;
-
-    for ( ; head; head = next ) {
-        next = head->next;
-        if ( head->cb == callback
-             && memcmp( &head->objref, objref, sizeof( *objref ) ) == 0 ) {
-            if ( prev )
-                prev->next = next;
-            else // if prev is null, means erasing node is the first node ...
-                s->head = next;
-
-            if ( bEraseLock )
-                head->cb = NULL;
-            else
-                free( head );
 
+    for ( i = 0; i < s->len; ++i ) {
+        sub_t* sub = &s->subs[i];
+        if ( sub->cb == callback
+             && memcmp( &sub->objref, objref, sizeof( *objref ) ) == 0 ) {
+            tombstone( s, sub );
             ++numDelete;
-            s->cnt -= bMulticast;
-        }
-        else {
-            // If any node deleted, previous node stay as previous ...
-            prev = head;
         }
     }
 
+    maybe_compact( s );
     return numDelete;
 }
 
+bool delegate_unsubscribe( delegate_t* s, delegate_handle_t h )
+{
+    uint32_t slot = (uint32_t)h;
+
+    uassert( s );
+    if ( slot >= s->slotHwm || s->slots[slot].gen != ( uint32_t )( h >> 32 ) )
+        return false;
+
+    tombstone( s, &s->subs[s->slots[slot].pos] );
+    maybe_compact( s );
+    return true;
+}
+
 void delegate_call( delegate_t* s, void* event_args )
 {
+    sub_t  cur;
+    size_t i, end;
+
     uassert( s );
-    // To keep iteration solid ...
-    s->bEraseLock          = true;
-    node_t*  pending_erase = NULL;
-    node_t** ppnext        = &s->head;
-
-    // Callback each element iterating all nodes
-    // Remove any node with its callback is NULL, or its object reference is
-    // expired.
-    for ( ; *ppnext; ) {
-        node_t* head = *ppnext;
-
-        // When this node is pending erase ...
-        if ( head->cb == NULL || ref_is_valid( &head->objref ) == false ) {
-            // Append to pending erase list
-            head->next    = pending_erase;
-            pending_erase = head;
-            *ppnext       = head->next;
-            s->cnt--;
+
+    // Subscriptions added by callbacks are not called until next call.
+    end = s->len;
+    ++s->callDepth;
+
+    for ( i = 0; i < end; ++i ) {
+        sub_t* sub = &s->subs[i];
+        if ( sub->cb == NULL )
             continue;
-        }
 
-        // When not erased ...
-        // Execute callback.
-        head->cb( &head->objref, event_args );
+        // Remove subscription whose object reference is expired.
+        if ( ref_is_valid( &sub->objref ) == false ) {
+            tombstone( s, sub );
+            continue;
+        }
 
-        ppnext = &head->next;
+        // Callback may grow the array, thus pass a copy.
+        cur = *sub;
+        cur.cb( &cur.objref, event_args );
     }
 
-    // Erase all pending erased nodes
-    node_t* next;
-    while ( pending_erase ) {
-        next = pending_erase->next;
-        free( pending_erase );
-        pending_erase = next;
-    }
-    s->bEraseLock = false;
+    if ( --s->callDepth == 0 && s->numTombs )
+        compact( s );
 }
 
 void delegate_destroy( delegate_t* s )
 {
-    uassert( s );
-    delegate_clear( s );
+    uassert( s && s->callDepth == 0 );
+    if ( s->subs != s->inlineSubs ) {
+        free( s->subs );
+        free( s->slots );
+    }
     free( s );
 }
 
 delegate_t* delegate_create( bool bMulticast )
 {
     delegate_t* ret = malloc( sizeof( delegate_t ) );
+    if ( ret == NULL )
+        return NULL;
+
+    ret->subs       = ret->inlineSubs;
+    ret->slots      = ret->inlineSlots;
+    ret->slotHwm    = 0;
+    ret->freeSlot   = SLOT_NONE;
+    ret->len        = 0;
+    ret->cap        = DELEGATE_INLINE_SUBS;
     ret->cnt        = 0;
-    ret->head       = NULL;
-    ret->bEraseLock = false;
+    ret->numTombs   = 0;
+    ret->callDepth  = 0;
     ret->bMulticast = bMulticast;
     return ret;
 }
@@ -5,21 +5,53 @@
 extern "C" {
 #endif
 
+//! \brief      Number of subscriptions stored inside the delegate itself.
+//!             Subscriptions are kept in single array, which moves to heap
+//!             once it outgrows this.
+#ifndef DELEGATE_INLINE_SUBS
+#    define DELEGATE_INLINE_SUBS 4
+#endif
+
 typedef struct delegate delegate_t;
 
+/*! \brief      Subscription handle. Packs generation on upper 32 bits with
+                slot of the subscription, thus removal through it is O(1).
+                Handle is invalidated when the subscription is removed by any
+                means. */
+typedef uint64_t delegate_handle_t;
+
+enum
+{
+    DELEGATE_HANDLE_NONE = 0
+};
+
 typedef void (
     *delegate_event_cb_t )( refhandle_t const* obj, void* event_args );
 
-void delegate_assign(
+/*! \returns    Handle of new subscription. Assigning to single cast delegate
+                replaces its subscription. */
+delegate_handle_t delegate_assign(
     delegate_t*         s,
     refhandle_t const*  objref,
     delegate_event_cb_t callback );
 void   delegate_clear( delegate_t* s );
 size_t delegate_size( delegate_t* s );
+
+/*! \brief      Remove every subscription of (objref, callback). O(n)
+    \returns    Number of removed subscriptions. */
 size_t delegate_delete(
     delegate_t*         s,
     refhandle_t const*  objref,
     delegate_event_cb_t callback );
+
+/*! \brief      Remove subscription by handle. Amortized O(1)
+    \returns    false if the handle is stale. */
+bool delegate_unsubscribe( delegate_t* s, delegate_handle_t h );
+
+/*! \brief      Invoke subscriptions in the order of assignment.
+    \details    Subscriptions whose object expired are removed. Removed
+                entries are left as tombstones during call, and squeezed out
+                after it. */
 void        delegate_call( delegate_t* s, void* event_args );
 void        delegate_destroy( delegate_t* s );
 delegate_t* delegate_create( bool bMulticast );
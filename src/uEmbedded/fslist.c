@@ -1,4 +1,6 @@
 #include "fslist.h"
+#include <string.h>
+#include "bitops.h"
 #include "uassert.h"
 
 typedef struct fslist_node node_t;
@@ -7,7 +9,6 @@ size_t
 fslist_init( struct fslist* s, void* buff, size_t buffSize, size_t elemSize )
 {
     size_t chunkSize = elemSize + sizeof( struct fslist_node );
-    size_t it;
     size_t cap;
 
     s->buff     = (char*)buff;
@@ -22,18 +23,12 @@ fslist_init( struct fslist* s, void* buff, size_t buffSize, size_t elemSize )
     s->data     = s->buff + s->capacity * sizeof( struct fslist_node );
 
     s->head = s->tail = FSLIST_NODEIDX_NONE;
-    s->inactive       = 0;
+    s->inactive       = FSLIST_NODEIDX_NONE;
+    s->hwm            = 0;
+    s->live           = NULL;
 
     s->size = 0;
 
-    // Link all nodes
-    for ( it = 0; it < s->capacity; ++it ) {
-        s->get[it].next    = ( fslist_idx_t )( it + 1 );
-        s->get[it].prev    = ( fslist_idx_t )( it - 1 );
-        s->get[it].isValid = false;
-    }
-    s->get[s->capacity - 1].next = FSLIST_NODEIDX_NONE;
-
     return s->capacity;
 }
 
@@ -42,16 +37,26 @@ struct fslist_node* fslist_insert( struct fslist* s, struct fslist_node* n )
     node_t*      newNode;
     fslist_idx_t nidx, newNodeIdx;
 
-    uassert( s->inactive != FSLIST_NODEIDX_NONE );
+    uassert( s->size < s->capacity );
     uassert( n == NULL || fslist_node_in_range( s, n ) );
     uassert( n == NULL || n->isValid );
 
-    // Allocate new node and insert before given node
-    newNode    = s->get + s->inactive;
-    newNodeIdx = s->inactive;
+    // Allocate new node from released ones first, then from never used ones.
+    if ( s->inactive != FSLIST_NODEIDX_NONE ) {
+        newNodeIdx  = s->inactive;
+        newNode     = s->get + newNodeIdx;
+        s->inactive = newNode->next;
+    }
+    else {
+        // Bitmap words are cleared lazily, as high-water mark enters them.
+        if ( s->live && s->hwm % 64 == 0 )
+            s->live[s->hwm / 64] = 0;
+        newNodeIdx = s->hwm++;
+        newNode    = s->get + newNodeIdx;
+    }
 
-    // Replace inactive node head.
-    s->inactive = newNode->next;
+    if ( s->live )
+        s->live[newNodeIdx / 64] |= (uint64_t)1 << ( newNodeIdx % 64 );
 
     nidx          = fslist_idx( s, n );
     newNode->next = nidx;
@@ -112,4 +117,130 @@ void fslist_erase( struct fslist* s, struct fslist_node* n )
 
     n->isValid = false;
     --s->size;
-}
\ No newline at end of file
+
+    if ( s->live )
+        s->live[nidx / 64] &= ~( (uint64_t)1 << ( nidx % 64 ) );
+}
+
+void fslist_attachLiveBits( struct fslist* s, uint64_t* bits )
+{
+    size_t i;
+
+    for ( i = 0; i < FSLIST_LIVE_WORDS( s->hwm ); ++i )
+        bits[i] = 0;
+    for ( i = 0; i < s->hwm; ++i ) {
+        if ( s->get[i].isValid )
+            bits[i / 64] |= (uint64_t)1 << ( i % 64 );
+    }
+    s->live = bits;
+}
+
+void fslist_forEachLiveRange(
+    struct fslist*         s,
+    size_t                 firstWord,
+    size_t                 lastWord,
+    fslist_live_callback_t callback,
+    void*                  caller )
+{
+    size_t       w;
+    uint64_t     bits;
+    fslist_idx_t idx;
+
+    uassert( s->live );
+    uassert( lastWord <= fslist_liveWords( s ) );
+
+    for ( w = firstWord; w < lastWord; ++w ) {
+        // Copied, so that the callback may erase the visited element.
+        for ( bits = s->live[w]; bits; bits &= bits - 1 ) {
+            idx = ( fslist_idx_t )( w * 64 + bit_ctz64( bits ) );
+            callback( caller, idx, s->data + idx * s->elemSize );
+        }
+    }
+}
+static void swap_bytes( char* a, char* b, size_t n )
+{
+    char t;
+    while ( n-- ) {
+        t    = *a;
+        *a++ = *b;
+        *b++ = t;
+    }
+}
+
+void fslist_compact(
+    struct fslist*             s,
+    fslist_relocate_callback_t relocated,
+    void*                      caller )
+{
+    fslist_idx_t idx, pos, next, origin;
+    node_t       tmp;
+
+    // During the pass, prev link of each element that's not placed yet holds
+    // its original index. Prev link of a placed node holds where the element
+    // which occupied it before went, so links to displaced elements can be
+    // followed.
+    for ( idx = s->head; idx != FSLIST_NODEIDX_NONE; idx = s->get[idx].next )
+        s->get[idx].prev = idx;
+
+    for ( pos = 0, idx = s->head; idx != FSLIST_NODEIDX_NONE;
+          ++pos, idx = next ) {
+        while ( idx < pos )
+            idx = s->get[idx].prev;
+
+        next   = s->get[idx].next;
+        origin = s->get[idx].prev;
+
+        if ( idx != pos ) {
+            if ( s->get[pos].isValid ) {
+                // Another element which comes later is in the place. Swap.
+                tmp         = s->get[pos];
+                s->get[pos] = s->get[idx];
+                s->get[idx] = tmp;
+                swap_bytes(
+                    s->data + pos * s->elemSize,
+                    s->data + idx * s->elemSize,
+                    s->elemSize );
+                s->get[pos].prev = idx;
+            }
+            else {
+                s->get[pos]         = s->get[idx];
+                s->get[idx].isValid = false;
+                memcpy(
+                    s->data + pos * s->elemSize,
+                    s->data + idx * s->elemSize,
+                    s->elemSize );
+                s->get[pos].prev = FSLIST_NODEIDX_NONE;
+            }
+        }
+        else {
+            s->get[pos].prev = FSLIST_NODEIDX_NONE;
+        }
+
+        if ( relocated && origin != pos )
+            relocated( caller, origin, pos );
+    }
+
+    // Rebuild links. Nodes beyond the active ones are never used again.
+    for ( idx = 0; idx < s->size; ++idx ) {
+        s->get[idx].prev = ( fslist_idx_t )( idx - 1 );
+        s->get[idx].next = ( fslist_idx_t )( idx + 1 );
+    }
+    for ( ; idx < s->hwm; ++idx )
+        s->get[idx].isValid = false;
+
+    if ( s->size ) {
+        s->get[0].prev           = FSLIST_NODEIDX_NONE;
+        s->get[s->size - 1].next = FSLIST_NODEIDX_NONE;
+        s->head                  = 0;
+        s->tail                  = ( fslist_idx_t )( s->size - 1 );
+    }
+    s->inactive = FSLIST_NODEIDX_NONE;
+    s->hwm      = s->size;
+
+    if ( s->live ) {
+        for ( idx = 0; idx < s->size / 64; ++idx )
+            s->live[idx] = ~(uint64_t)0;
+        if ( s->size % 64 )
+            s->live[idx] = ( (uint64_t)1 << ( s->size % 64 ) ) - 1;
+    }
+}
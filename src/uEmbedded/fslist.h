@@ -45,9 +45,13 @@ struct fslist
     //! \breif      Last reference of active nodes.
     fslist_idx_t tail;
 
-    //! \brief      First reference of inactive(=available) node.
+    //! \brief      First reference of released(=available) node.
     fslist_idx_t inactive;
 
+    //! \brief      High-water mark. Nodes from this index were never used, and
+    //! are taken when there's no released node.
+    fslist_idx_t hwm;
+
     //! \brief      Number of maximum nodes.
     fslist_idx_t capacity;
 
@@ -68,6 +72,10 @@ struct fslist
     //! \brief      Easy accessor for referencing element data. This member is
     //! for internal use !
     char* data;
+
+    //! \brief      Optional occupancy bitmap. Bit n is set while node n is
+    //! active. NULL unless attached by fslist_attachLiveBits.
+    uint64_t* live;
 };
 
 //! \brief      List node struct.
@@ -86,7 +94,12 @@ enum
     FSLIST_NODE_SIZE = sizeof( struct fslist_node )
 };
 
+//! \brief      Number of bitmap words required for given capacity.
+#define FSLIST_LIVE_WORDS( capacity ) ( ( (size_t)( capacity ) + 63 ) / 64 )
+
 /*! \brief      Initiate node struct
+    \details    O(1). Nodes are linked lazily, thus the buffer is not touched
+                until it's used.
     \param      buff
                  Buffer to be used internally. This memory chunk must be
                 valid during usage. After the deallocation of fslist, the
@@ -162,6 +175,67 @@ struct fslist_node* fslist_insert( struct fslist* s, struct fslist_node* n );
 /*! \brief      Remove given node from list. */
 void fslist_erase( struct fslist* s, struct fslist_node* n );
 
+/*! \brief      Called for each element relocated by fslist_compact. */
+typedef void ( *fslist_relocate_callback_t )(
+    void* /*caller*/,
+    fslist_idx_t /*from*/,
+    fslist_idx_t /*to*/ );
+
+/*! \brief      Relocate active elements, so that list order matches memory
+                order.
+    \details    After compaction, n-th element of the list is stored at index
+                n, thus iteration sweeps node and data arrays linearly. O(n)
+                and done in place.
+    \param      relocated
+                 Invoked with the original and the new index of every moved
+                element, after it's moved. Use it to fix up any external
+                references to nodes. Can be NULL. */
+void fslist_compact(
+    struct fslist*             s,
+    fslist_relocate_callback_t relocated,
+    void*                      caller );
+
+/*! \brief      Attach occupancy bitmap to the list.
+    \details    Lets active elements be found by scanning 64 nodes per word,
+                instead of chasing links. Bits of currently active nodes are
+                set here, in O(hwm). The bitmap is kept up to date afterwards.
+    \param      bits
+                 FSLIST_LIVE_WORDS( s->capacity ) words, which must be valid
+                during usage. Need not be initialized. */
+void fslist_attachLiveBits( struct fslist* s, uint64_t* bits );
+
+/*! \brief      Number of bitmap words which may hold an active node. */
+static inline size_t fslist_liveWords( struct fslist const* s )
+{
+    return FSLIST_LIVE_WORDS( s->hwm );
+}
+
+/*! \brief      Called for each active element by fslist_forEachLive. */
+typedef void ( *fslist_live_callback_t )(
+    void* /*caller*/,
+    fslist_idx_t /*idx*/,
+    void* /*elem*/ );
+
+/*! \brief      Visit active elements of bitmap words [firstWord, lastWord)
+                in index order, regardless of list order.
+    \details    Requires attached bitmap. Callback may erase the visited
+                element through the given idx, but must not insert or erase
+                others. Disjoint word ranges can be visited from different
+                threads at once, if the callbacks don't modify the list. */
+void fslist_forEachLiveRange(
+    struct fslist*         s,
+    size_t                 firstWord,
+    size_t                 lastWord,
+    fslist_live_callback_t callback,
+    void*                  caller );
+
+/*! \brief      Visit every active element in index order. */
+static inline void fslist_forEachLive(
+    struct fslist* s, fslist_live_callback_t callback, void* caller )
+{
+    fslist_forEachLiveRange( s, 0, fslist_liveWords( s ), callback, caller );
+}
+
 //! @}
 //! @}
 
@@ -0,0 +1,142 @@
+#include "fslist_cpool.h"
+#include "uassert.h"
+
+#ifndef __STDC_NO_ATOMICS__
+#    include <stdatomic.h>
+
+enum
+{
+    CACHE_LINE = 64
+};
+
+struct fslist_cpool
+{
+    // Upper 32 bits are ABA tag, lower 32 bits are top index.
+    atomic_uint_least64_t top;
+    char                  pad[CACHE_LINE];
+
+    uint32_t               capacity;
+    atomic_uint_least32_t* next;
+};
+
+static inline uint_least64_t
+pack_top( uint_least64_t prevTop, uint32_t idx )
+{
+    return ( ( ( prevTop >> 32 ) + 1 ) << 32 ) | idx;
+}
+
+fslist_cpool_t* fslist_cpool_create( uint32_t capacity )
+{
+    fslist_cpool_t* p;
+    uint32_t        i;
+
+    uassert( capacity < (uint32_t)FSLIST_CPOOL_NONE );
+
+    p = malloc( sizeof( fslist_cpool_t ) );
+    if ( p == NULL )
+        return NULL;
+
+    p->capacity = capacity;
+    p->next     = malloc( ( capacity ? capacity : 1 ) * sizeof *p->next );
+    if ( p->next == NULL ) {
+        free( p );
+        return NULL;
+    }
+
+    for ( i = 0; i < capacity; ++i )
+        atomic_init(
+            &p->next[i],
+            i + 1 < capacity ? i + 1 : (uint32_t)FSLIST_CPOOL_NONE );
+    atomic_init(
+        &p->top, capacity ? 0 : (uint_least64_t)(uint32_t)FSLIST_CPOOL_NONE );
+
+    return p;
+}
+
+void fslist_cpool_destroy( fslist_cpool_t* p )
+{
+    free( p->next );
+    free( p );
+}
+
+uint32_t fslist_cpool_capacity( fslist_cpool_t const* p )
+{
+    return p->capacity;
+}
+
+uint32_t fslist_cpool_pop( fslist_cpool_t* p )
+{
+    uint32_t idx;
+    return fslist_cpool_popBatch( p, &idx, 1 ) ? idx
+                                               : (uint32_t)FSLIST_CPOOL_NONE;
+}
+
+void fslist_cpool_push( fslist_cpool_t* p, uint32_t idx )
+{
+    fslist_cpool_pushBatch( p, &idx, 1 );
+}
+
+uint32_t
+fslist_cpool_popBatch( fslist_cpool_t* p, uint32_t* out, uint32_t max )
+{
+    uint_least64_t top
+        = atomic_load_explicit( &p->top, memory_order_acquire );
+    uint32_t idx, n;
+
+    for ( ;; ) {
+        idx = (uint32_t)top;
+        if ( idx == (uint32_t)FSLIST_CPOOL_NONE || max == 0 )
+            return 0;
+
+        // Links may be stale if nodes are taken by other threads meanwhile.
+        // Then the tag has changed, and CAS fails.
+        for ( n = 0; n < max && idx != (uint32_t)FSLIST_CPOOL_NONE; ++n ) {
+            out[n] = idx;
+            idx    = atomic_load_explicit(
+                &p->next[idx], memory_order_relaxed );
+
+            // Stale link may point anywhere.
+            if ( idx >= p->capacity )
+                idx = (uint32_t)FSLIST_CPOOL_NONE;
+        }
+
+        if ( atomic_compare_exchange_weak_explicit(
+                 &p->top,
+                 &top,
+                 pack_top( top, idx ),
+                 memory_order_acquire,
+                 memory_order_acquire ) )
+            return n;
+    }
+}
+
+void fslist_cpool_pushBatch(
+    fslist_cpool_t* p, uint32_t const* idx, uint32_t n )
+{
+    uint_least64_t top;
+    uint32_t       i;
+
+    if ( n == 0 )
+        return;
+
+    // Chain is linked privately, then published with single CAS.
+    for ( i = 0; i + 1 < n; ++i ) {
+        uassert( idx[i] < p->capacity );
+        atomic_store_explicit(
+            &p->next[idx[i]], idx[i + 1], memory_order_relaxed );
+    }
+    uassert( idx[n - 1] < p->capacity );
+
+    top = atomic_load_explicit( &p->top, memory_order_relaxed );
+    do {
+        atomic_store_explicit(
+            &p->next[idx[n - 1]], (uint32_t)top, memory_order_relaxed );
+    } while ( !atomic_compare_exchange_weak_explicit(
+        &p->top,
+        &top,
+        pack_top( top, idx[0] ),
+        memory_order_release,
+        memory_order_relaxed ) );
+}
+
+#endif
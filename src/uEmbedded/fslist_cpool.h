@@ -0,0 +1,111 @@
+/*! \brief      Lock-free node index pool
+    \file       fslist_cpool.h
+    \author     Seungwoo Kang (ki6080@gmail.com)
+    \copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+
+    \details
+      Hands out free node indexes of a preallocated node array to any number
+      of threads, without lock. Free indexes form a Treiber stack whose top
+      word packs an ABA tag with the index, so it's swapped with single CAS.
+      Each thread may keep a magazine, which caches free indexes locally.
+      Allocation and release through magazine touch shared state only once
+      per FSLIST_MAGAZINE_BATCH operations, moving whole batch with single
+      CAS; otherwise they're wait-free.
+      Requires C11 atomics.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! @addtogroup uEmbedded_C
+//! @{
+//! @defgroup   uEmbedded_C_Concurrent_Free_Space_List
+//! @brief      Lock-free node index pool
+//! @{
+
+enum
+{
+    FSLIST_CPOOL_NONE = -1,
+
+    //! Number of indexes moved between magazine and shared pool at once.
+    FSLIST_MAGAZINE_BATCH = 16,
+    FSLIST_MAGAZINE_SIZE  = FSLIST_MAGAZINE_BATCH * 2
+};
+
+typedef struct fslist_cpool fslist_cpool_t;
+
+//! \brief      Per-thread cache of free indexes. Must not be shared between
+//!             threads. Zero-initialize before use.
+typedef struct fslist_magazine
+{
+    uint32_t count;
+    uint32_t idx[FSLIST_MAGAZINE_SIZE];
+} fslist_magazine_t;
+
+/*! \brief      Create pool of indexes [0, capacity), all free.
+    \returns    NULL on allocation failure. */
+fslist_cpool_t* fslist_cpool_create( uint32_t capacity );
+
+void fslist_cpool_destroy( fslist_cpool_t* p );
+
+uint32_t fslist_cpool_capacity( fslist_cpool_t const* p );
+
+/*! \brief      Take single free index. Lock-free.
+    \returns    (uint32_t)FSLIST_CPOOL_NONE if the pool is exhausted. */
+uint32_t fslist_cpool_pop( fslist_cpool_t* p );
+
+/*! \brief      Release single index. Lock-free. */
+void fslist_cpool_push( fslist_cpool_t* p, uint32_t idx );
+
+/*! \brief      Take up to max free indexes with single CAS.
+    \returns    Number of indexes written into out. */
+uint32_t
+fslist_cpool_popBatch( fslist_cpool_t* p, uint32_t* out, uint32_t max );
+
+/*! \brief      Release n indexes with single CAS. */
+void fslist_cpool_pushBatch(
+    fslist_cpool_t* p, uint32_t const* idx, uint32_t n );
+
+/*! \brief      Take free index through magazine of calling thread.
+    \returns    (uint32_t)FSLIST_CPOOL_NONE if the pool is exhausted. Indexes
+                cached by magazines of other threads are not visible. */
+static inline uint32_t
+fslist_magazine_alloc( fslist_magazine_t* m, fslist_cpool_t* p )
+{
+    if ( m->count == 0 )
+        m->count = fslist_cpool_popBatch( p, m->idx, FSLIST_MAGAZINE_BATCH );
+    return m->count ? m->idx[--m->count] : (uint32_t)FSLIST_CPOOL_NONE;
+}
+
+/*! \brief      Release index through magazine of calling thread. */
+static inline void
+fslist_magazine_free( fslist_magazine_t* m, fslist_cpool_t* p, uint32_t idx )
+{
+    if ( m->count == FSLIST_MAGAZINE_SIZE ) {
+        m->count -= FSLIST_MAGAZINE_BATCH;
+        fslist_cpool_pushBatch(
+            p, m->idx + m->count, FSLIST_MAGAZINE_BATCH );
+    }
+    m->idx[m->count++] = idx;
+}
+
+/*! \brief      Return every cached index to the pool. Call before the thread
+                exits. */
+static inline void
+fslist_magazine_flush( fslist_magazine_t* m, fslist_cpool_t* p )
+{
+    fslist_cpool_pushBatch( p, m->idx, m->count );
+    m->count = 0;
+}
+
+//! @}
+//! @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,79 +1,382 @@
 #include "managed_reference_pool.h"
 #include <stdio.h>
+#include <string.h>
 #include "uassert.h"
 
-typedef struct refnode
+#ifndef __STDC_NO_ATOMICS__
+#    include <stdatomic.h>
+#endif
+
+enum
 {
-    void*    ref;
-    uint32_t id;
-    int16_t  lockcnt;
-    bool     pending_free;
-} refnode_t;
+    REFPOOL_SLAB_ALIGN = 16,
+    REFPOOL_SLAB_NONE  = 0xff,
+    REFPOOL_SLAB_NULL  = -1u
+};
+
+struct refpool_slab
+{
+    char*    base;
+    size_t   stride;
+    uint32_t count;
+    uint32_t hwm;      // Objects from hwm were never handed out.
+    uint32_t freeHead; // Free list threaded through released objects.
+};
 
 struct managed_reference_pool
 {
     /*data*/
     struct managed_reference_pool* ref_to_myself;
     uint32_t                       idgen;
-    struct fslist                  refs;
+    uint16_t                       tableId;
+    uint32_t                       tagBase;
+    size_t                         numChunks;
+    size_t                         maxChunks;
+    size_t                         chunkBuffSz;
+    struct fslist                  chunks[REFPOOL_MAX_CHUNKS];
+    allocator_ref_t                alloc;
+    size_t                         numSlabs;
+    struct refpool_slab            slabs[];
 };
 
+struct refpool_entry g_refpool_table[REFPOOL_MAX_POOLS];
+
+#ifndef __STDC_NO_ATOMICS__
+// Serializes claiming and releasing table entries, so pools can be created
+// and destroyed from any thread. Only held for a scan over the table.
+static atomic_flag g_refpool_table_lock = ATOMIC_FLAG_INIT;
+
+static void table_lock( void )
+{
+    while ( atomic_flag_test_and_set_explicit(
+        &g_refpool_table_lock, memory_order_acquire ) )
+        ;
+}
+
+static void table_unlock( void )
+{
+    atomic_flag_clear_explicit( &g_refpool_table_lock, memory_order_release );
+}
+#else
+static void table_lock( void ) {}
+static void table_unlock( void ) {}
+#endif
+
+static uint32_t
+node_gen( managed_reference_pool_t const* s, refnode_t const* data )
+{
+    return ( data->id + s->tagBase ) & REFHANDLE64_MASK;
+}
+
+static uint16_t table_register( managed_reference_pool_t* s )
+{
+    uint16_t i;
+
+    table_lock();
+    for ( i = 1; i < REFPOOL_MAX_POOLS; ++i ) {
+        if ( g_refpool_table[i].pool == NULL ) {
+            g_refpool_table[i].pool = s;
+            s->tagBase              = g_refpool_table[i].tagBase;
+            break;
+        }
+    }
+    table_unlock();
+    return i < REFPOOL_MAX_POOLS ? i : 0;
+}
+
+// Entry is cleared before it's handed back, so next pool claiming it never
+// sees its views zeroed afterwards.
+static void table_unregister( managed_reference_pool_t* s )
+{
+    struct refpool_entry* e = &g_refpool_table[s->tableId];
+
+    table_lock();
+    memset( e->chunks, 0, sizeof e->chunks );
+    e->tagBase = s->tagBase + s->idgen;
+    e->pool    = NULL;
+    table_unlock();
+}
+
+// Exposes nodes below high-water mark of the chunk to compact handles. Nodes
+// above it were never initialized.
+static void table_update( managed_reference_pool_t* s, size_t chunk )
+{
+    struct refpool_view* v;
+
+    if ( s->tableId == 0 )
+        return;
+
+    v = &g_refpool_table[s->tableId].chunks[chunk];
+    if ( s->chunks[chunk].buff == NULL ) {
+        v->nodes    = NULL;
+        v->capacity = 0;
+    }
+    else if ( v->capacity < s->chunks[chunk].hwm ) {
+        v->nodes    = (refnode_t*)s->chunks[chunk].data;
+        v->capacity = s->chunks[chunk].hwm;
+    }
+}
+
+static bool chunk_grow( managed_reference_pool_t* s )
+{
+    void* buff;
+
+    if ( s->numChunks == s->maxChunks )
+        return false;
+
+    buff = s->alloc->allocate( s->alloc->object, s->chunkBuffSz );
+    if ( buff == NULL )
+        return false;
+
+    fslist_init(
+        &s->chunks[s->numChunks], buff, s->chunkBuffSz, sizeof( refnode_t ) );
+    ++s->numChunks;
+    return true;
+}
+
+// Node of the handle, if it's in use or has been used.
+static refnode_t*
+node_of( managed_reference_pool_t* s, refhandle_t const* h )
+{
+    struct fslist* c;
+    fslist_idx_t   idx;
+
+    if ( h->chunk >= s->numChunks )
+        return NULL;
+
+    c   = &s->chunks[h->chunk];
+    idx = fslist_idx( c, h->node );
+    return idx < c->hwm ? (refnode_t*)c->data + idx : NULL;
+}
+
+static size_t slab_round( size_t sz )
+{
+    size_t const mask = REFPOOL_SLAB_ALIGN - 1;
+    return ( sz + mask ) & ~mask;
+}
+
 managed_reference_pool_t* refpool_create( size_t numMaxRef )
 {
-    managed_reference_pool_t* s = malloc( sizeof( managed_reference_pool_t ) );
+    return refpool_create_ex( numMaxRef, NULL, NULL, 0 );
+}
+
+managed_reference_pool_t* refpool_create_ex(
+    size_t                      numMaxRef,
+    allocator_ref_t             alloc,
+    refpool_slab_class_t const* classes,
+    size_t                      numClasses )
+{
+    return refpool_create_growable( numMaxRef, 1, alloc, classes, numClasses );
+}
+
+managed_reference_pool_t* refpool_create_growable(
+    size_t                      numRefPerChunk,
+    size_t                      maxChunks,
+    allocator_ref_t             alloc,
+    refpool_slab_class_t const* classes,
+    size_t                      numClasses )
+{
+    managed_reference_pool_t* s;
+    size_t                    buffSz, blockSz, i;
+    char*                     block;
+
+    uassert( numClasses < REFPOOL_SLAB_NONE );
+    uassert( 0 < maxChunks && maxChunks <= REFPOOL_MAX_CHUNKS );
+    s = malloc(
+        sizeof( managed_reference_pool_t )
+        + numClasses * sizeof( struct refpool_slab ) );
     if ( s == NULL )
         return NULL;
 
-    size_t buffSz = numMaxRef * ( FSLIST_NODE_SIZE + sizeof( refnode_t ) );
+    // Slabs are laid out right after the node array, in one block.
+    buffSz  = numRefPerChunk * ( FSLIST_NODE_SIZE + sizeof( refnode_t ) );
+    blockSz = slab_round( buffSz );
+    for ( i = 0; i < numClasses; ++i ) {
+        uassert( classes[i].count < REFPOOL_SLAB_NULL );
+        uassert( i == 0 || classes[i - 1].objSize <= classes[i].objSize );
+        blockSz += classes[i].count * slab_round( classes[i].objSize );
+    }
+
+    block = malloc( blockSz );
+    if ( block == NULL ) {
+        free( s );
+        return NULL;
+    }
 
     s->idgen = 0;
-    fslist_init( &s->refs, malloc( buffSz ), buffSz, sizeof( refnode_t ) );
+    for ( i = 0; i < REFPOOL_MAX_CHUNKS; ++i )
+        fslist_init( &s->chunks[i], NULL, 0, sizeof( refnode_t ) );
+    fslist_init( &s->chunks[0], block, buffSz, sizeof( refnode_t ) );
+    uassert( s->chunks[0].capacity == numRefPerChunk );
+
+    s->numChunks   = 1;
+    s->maxChunks   = maxChunks;
+    s->chunkBuffSz = buffSz;
+
+    s->alloc    = alloc ? alloc : &g_mallocator;
+    s->numSlabs = numClasses;
+    block += slab_round( buffSz );
+    for ( i = 0; i < numClasses; ++i ) {
+        struct refpool_slab* sl = s->slabs + i;
+
+        // Free list link is stored in released objects, thus no stride is 0.
+        sl->stride = slab_round( classes[i].objSize );
+        if ( sl->stride == 0 )
+            sl->stride = REFPOOL_SLAB_ALIGN;
+        sl->base     = block;
+        sl->count    = (uint32_t)classes[i].count;
+        sl->hwm      = 0;
+        sl->freeHead = REFPOOL_SLAB_NULL;
+        block += sl->count * sl->stride;
+    }
 
-    uassert( s->refs.capacity == numMaxRef );
     s->ref_to_myself = s;
+    s->tagBase       = 0;
+    s->tableId       = table_register( s );
     return s;
 }
 
+static void*
+obj_alloc( managed_reference_pool_t* s, size_t size, uint8_t* slab )
+{
+    size_t i;
+    char*  p;
+
+    for ( i = 0; i < s->numSlabs; ++i ) {
+        struct refpool_slab* sl = s->slabs + i;
+        if ( sl->stride < size )
+            continue;
+
+        if ( sl->freeHead != REFPOOL_SLAB_NULL ) {
+            p            = sl->base + sl->freeHead * sl->stride;
+            sl->freeHead = *(uint32_t*)p;
+        }
+        else if ( sl->hwm < sl->count ) {
+            p = sl->base + sl->hwm++ * sl->stride;
+        }
+        else {
+            continue;
+        }
+
+        *slab = (uint8_t)i;
+        return p;
+    }
+
+    *slab = REFPOOL_SLAB_NONE;
+    return s->alloc->allocate( s->alloc->object, size );
+}
+
+static void obj_free( managed_reference_pool_t* s, refnode_t* data )
+{
+    struct refpool_slab* sl;
+
+    if ( data->slab == REFPOOL_SLAB_NONE ) {
+        s->alloc->release( s->alloc->object, data->ref );
+        return;
+    }
+
+    sl                    = s->slabs + data->slab;
+    *(uint32_t*)data->ref = sl->freeHead;
+    sl->freeHead = (uint32_t)( ( (char*)data->ref - sl->base ) / sl->stride );
+}
+
 refhandle_t refpool_malloc( managed_reference_pool_t* s, size_t memsize )
 {
-    uassert( s && s->refs.size < s->refs.capacity );
+    size_t              chunk;
+    struct fslist*      c;
+    struct fslist_node* n;
+    refnode_t*          data;
+    refhandle_t         ret;
+
+    uassert( s );
+    ret.s     = &s->ref_to_myself;
+    ret.node  = NULL;
+    ret.chunk = 0;
+    ret.id    = OBJECTID_NULL;
+
+    // Lower chunks are filled first, so that trailing ones can drain.
+    for ( chunk = 0; chunk < s->numChunks; ++chunk ) {
+        if ( s->chunks[chunk].size < s->chunks[chunk].capacity )
+            break;
+    }
+    if ( chunk == s->numChunks && chunk_grow( s ) == false )
+        return ret;
 
-    struct fslist_node* n    = fslist_insert( &s->refs, NULL );
-    refnode_t*          data = fslist_data( &s->refs, n );
+    c    = &s->chunks[chunk];
+    n    = fslist_insert( c, NULL );
+    data = fslist_data( c, n );
     uassert( n && data );
 
+    data->ref = obj_alloc( s, memsize, &data->slab );
+    if ( data->ref == NULL ) {
+        // Node stays below high-water mark, thus must not match any handle.
+        data->id  = OBJECTID_NULL;
+        data->tag = REFNODE_TAG_DEAD;
+        fslist_erase( c, n );
+        return ret;
+    }
+
     data->id           = s->idgen++;
     data->pending_free = false;
-    data->ref          = malloc( memsize );
+    data->tag          = node_gen( s, data );
     data->lockcnt      = 0;
 
-    refhandle_t ret;
-    ret.id   = data->id;
-    ret.node = n;
-    ret.s    = &s->ref_to_myself;
+    table_update( s, chunk );
+
+    ret.id    = data->id;
+    ret.node  = n;
+    ret.chunk = (uint32_t)chunk;
     return ret;
 }
 
 size_t refpool_num_available( managed_reference_pool_t* s )
 {
-    return s->refs.capacity - s->refs.size;
+    size_t i, n = s->maxChunks * s->chunks[0].capacity;
+
+    for ( i = 0; i < s->numChunks; ++i )
+        n -= s->chunks[i].size;
+    return n;
+}
+
+size_t refpool_shrink( managed_reference_pool_t* s )
+{
+    size_t         n = 0;
+    struct fslist* c;
+
+    uassert( s );
+    while ( s->numChunks > 1 && s->chunks[s->numChunks - 1].size == 0 ) {
+        c = &s->chunks[--s->numChunks];
+        s->alloc->release( s->alloc->object, c->buff );
+        fslist_init( c, NULL, 0, sizeof( refnode_t ) );
+        table_update( s, s->numChunks );
+        ++n;
+    }
+    return n;
 }
 
-static void release_all( void* nouse_, refhandle_t* h )
+static void release_all( void* pool, refhandle_t* h )
 {
-    free( ref_lock( h ) );
+    managed_reference_pool_t* s = pool;
+    obj_free( s, node_of( s, h ) );
 }
 
 void refpool_destroy( managed_reference_pool_t* s )
 {
+    size_t i;
+
     // Release all memory
-    refpool_foreach( s, NULL, release_all );
+    refpool_foreach( s, s, release_all );
 
     // Releaes ref to myself
     s->ref_to_myself = NULL;
-
-    // Erase ref to myself
-    free( s->refs.buff );
+    if ( s->tableId )
+        table_unregister( s );
+
+    // Erase ref to myself. First chunk holds slabs as well, and is the only
+    // one allocated along with the pool.
+    free( s->chunks[0].buff );
+    for ( i = 1; i < s->numChunks; ++i )
+        s->alloc->release( s->alloc->object, s->chunks[i].buff );
     free( s );
 }
 
@@ -84,32 +387,93 @@ void refpool_foreach(
 {
     uassert( s && cb );
 
-    if ( s->refs.size == 0 )
-        return;
-
-    // First node ref
-    struct fslist_node* n = &s->refs.get[s->refs.head];
+    struct fslist*      c;
+    struct fslist_node* n;
     refnode_t*          objref;
     refhandle_t         h;
     h.s = &s->ref_to_myself;
 
-    while ( n ) {
-        objref = fslist_data( &s->refs, n );
+    for ( h.chunk = 0; h.chunk < s->numChunks; ++h.chunk ) {
+        c = &s->chunks[h.chunk];
+        if ( c->size == 0 )
+            continue;
 
-        // Make handle from node
-        h.node = n;
-        h.id   = objref->id;
+        // First node ref
+        n = &c->get[c->head];
 
-        // Lock node to prevent iteration breakdown
-        if ( ref_lock( &h ) ) {
-            // Callback.
-            cb( caller, &h );
+        while ( n ) {
+            objref = fslist_data( c, n );
 
-            n = fslist_next( &s->refs, n );
-            ref_unlock( &h );
+            // Make handle from node
+            h.node = n;
+            h.id   = objref->id;
+
+            // Lock node to prevent iteration breakdown
+            if ( ref_lock( &h ) ) {
+                // Callback.
+                cb( caller, &h );
+
+                n = fslist_next( c, n );
+                ref_unlock( &h );
+            }
+            else {
+                n = fslist_next( c, n );
+            }
         }
-        else {
-            n = fslist_next( &s->refs, n );
+    }
+}
+
+struct compact_ctx
+{
+    managed_reference_pool_t*  s;
+    uint32_t                   chunk;
+    void*                      caller;
+    refpool_foreach_callback_t cb;
+};
+
+static void refpool_relocated( void* obj, fslist_idx_t from, fslist_idx_t to )
+{
+    struct compact_ctx* ctx = obj;
+    refnode_t*          data;
+    refhandle_t         h;
+
+    (void)from;
+    h.s     = &ctx->s->ref_to_myself;
+    h.chunk = ctx->chunk;
+    h.node  = ctx->s->chunks[h.chunk].get + to;
+    data    = node_of( ctx->s, &h );
+    h.id    = data->id;
+
+    uassert( data->lockcnt == 0 );
+    if ( ctx->cb )
+        ctx->cb( ctx->caller, &h );
+}
+
+void refpool_compact(
+    managed_reference_pool_t*  s,
+    void*                      caller,
+    refpool_foreach_callback_t cb )
+{
+    struct compact_ctx ctx;
+    struct fslist*     c;
+    fslist_idx_t       idx, hwm;
+
+    uassert( s );
+    ctx.s      = s;
+    ctx.caller = caller;
+    ctx.cb     = cb;
+
+    for ( ctx.chunk = 0; ctx.chunk < s->numChunks; ++ctx.chunk ) {
+        c   = &s->chunks[ctx.chunk];
+        hwm = c->hwm;
+        fslist_compact( c, refpool_relocated, &ctx );
+
+        // Stale copies are left behind moved nodes. Invalidate them, so that
+        // old handles can't match their ids.
+        for ( idx = c->size; idx < hwm; ++idx ) {
+            refnode_t* stale = (refnode_t*)c->data + idx;
+            stale->id        = OBJECTID_NULL;
+            stale->tag       = REFNODE_TAG_DEAD;
         }
     }
 }
@@ -123,7 +487,7 @@ void* ref_lock( refhandle_t* h )
     if ( s == NULL )
         return NULL;
 
-    refnode_t* data = fslist_data( &s->refs, h->node );
+    refnode_t* data = node_of( s, h );
 
     if ( data && data->id == h->id && data->pending_free == false ) {
         uassert( data->ref );
@@ -144,7 +508,7 @@ void ref_unlock( refhandle_t* h )
     if ( s == NULL )
         return;
 
-    refnode_t* data = fslist_data( &s->refs, h->node );
+    refnode_t* data = node_of( s, h );
 
     if ( data && data->id == h->id ) {
         uassert( data->lockcnt > 0 );
@@ -153,9 +517,10 @@ void ref_unlock( refhandle_t* h )
         // Erase node
         if ( data->pending_free && data->lockcnt == 0 ) {
             uassert( data->ref );
-            free( data->ref );
-            data->id = OBJECTID_NULL;
-            fslist_erase( &s->refs, h->node );
+            obj_free( s, data );
+            data->id  = OBJECTID_NULL;
+            data->tag = REFNODE_TAG_DEAD;
+            fslist_erase( &s->chunks[h->chunk], h->node );
         }
     }
 }
@@ -169,18 +534,20 @@ bool ref_free( refhandle_t* h )
     if ( s == NULL )
         return NULL;
 
-    refnode_t* data = fslist_data( &s->refs, h->node );
+    refnode_t* data = node_of( s, h );
 
     if ( data && data->id == h->id ) {
         if ( data->lockcnt ) {
             data->pending_free = true;
+            data->tag          = REFNODE_TAG_DEAD;
             return true;
         }
 
         // Erase node
-        free( data->ref );
-        data->id = OBJECTID_NULL;
-        fslist_erase( &s->refs, h->node );
+        obj_free( s, data );
+        data->id  = OBJECTID_NULL;
+        data->tag = REFNODE_TAG_DEAD;
+        fslist_erase( &s->chunks[h->chunk], h->node );
         return true;
     }
     else {
@@ -190,12 +557,12 @@ bool ref_free( refhandle_t* h )
 
 bool ref_is_valid( refhandle_t const* h )
 {
-    // Check if reference is alive.
+    // Check if reference is alive. Failed allocation gives null id.
     managed_reference_pool_t* s = *h->s;
-    if ( s == NULL )
+    if ( s == NULL || h->id == OBJECTID_NULL )
         return false;
 
-    refnode_t* data = fslist_data( &s->refs, h->node );
+    refnode_t* data = node_of( s, h );
 
     if ( data && data->id == h->id && data->pending_free == false ) {
         return true;
@@ -203,4 +570,64 @@ bool ref_is_valid( refhandle_t const* h )
     else {
         return false;
     }
-}
\ No newline at end of file
+}
+
+refhandle64_t ref_compact( refhandle_t const* h )
+{
+    managed_reference_pool_t* s;
+    uint64_t                  slot;
+
+    if ( ref_is_valid( h ) == false )
+        return REFHANDLE64_NULL;
+
+    s = *h->s;
+    if ( s->tableId == 0 )
+        return REFHANDLE64_NULL;
+
+    slot = (uint64_t)h->chunk << REFHANDLE64_INDEX_BITS
+           | fslist_idx( &s->chunks[h->chunk], h->node );
+    uassert( slot <= REFHANDLE64_MASK );
+    return (uint64_t)s->tableId << 48 | slot << REFHANDLE64_BITS
+           | node_of( s, h )->tag;
+}
+
+// Classic handle of the node, which is known to be alive.
+static refhandle_t ref64_expand( refhandle64_t h, refnode_t const* n )
+{
+    managed_reference_pool_t* s = g_refpool_table[h >> 48].pool;
+    refhandle_t               ret;
+    struct fslist*            c;
+
+    ret.s     = &s->ref_to_myself;
+    ret.chunk = ( h >> REFHANDLE64_BITS & REFHANDLE64_MASK )
+                >> REFHANDLE64_INDEX_BITS;
+    c         = &s->chunks[ret.chunk];
+    ret.node  = c->get + ( n - (refnode_t const*)c->data );
+    ret.id    = n->id;
+    return ret;
+}
+
+void ref64_unlock( refhandle64_t h )
+{
+    refnode_t*  n = ref64_node_( h );
+    refhandle_t full;
+
+    // Tag is dead while pending free, thus compare the generation instead.
+    uassert( n );
+    uassert(
+        node_gen( g_refpool_table[h >> 48].pool, n )
+        == ( h & REFHANDLE64_MASK ) );
+    full = ref64_expand( h, n );
+    ref_unlock( &full );
+}
+
+bool ref64_free( refhandle64_t h )
+{
+    refhandle_t full;
+
+    if ( ref64_is_valid( h ) == false )
+        return false;
+
+    full = ref64_expand( h, ref64_node_( h ) );
+    return ref_free( &full );
+}
@@ -11,11 +11,23 @@
 #pragma once
 #include <stdint.h>
 #include <stdlib.h>
+#include "allocator.h"
 #include "fslist.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
+
+//! \brief      Number of pools which can hand out compact handles at once.
+#ifndef REFPOOL_MAX_POOLS
+#    define REFPOOL_MAX_POOLS 32
+#endif
+
+//! \brief      Number of node chunks which single pool can grow into.
+#ifndef REFPOOL_MAX_CHUNKS
+#    define REFPOOL_MAX_CHUNKS 8
+#endif
+
 enum
 {
     OBJECTID_NULL = -1u
@@ -26,15 +38,127 @@ typedef struct refhandle
     struct managed_reference_pool** s;
     struct fslist_node*             node;
     uint32_t                        id;
+    uint32_t                        chunk;
 } refhandle_t;
 
 typedef struct managed_reference_pool managed_reference_pool_t;
 
+/*! \brief      Compact reference handle.
+    \details
+      Packs 16-bit pool id, 24-bit node slot and 24-bit generation into single
+      word, from the most significant bits. Slot consists of chunk index and
+      node index in the chunk. Nodes are resolved through g_refpool_table, thus
+      checking the handle costs one indexed load and a compare, without
+      touching the pool. Value 0 is never valid. */
+typedef uint64_t refhandle64_t;
+
+enum
+{
+    REFHANDLE64_NULL = 0,
+    REFHANDLE64_BITS = 24,
+    REFHANDLE64_MASK = ( 1 << REFHANDLE64_BITS ) - 1,
+
+    //! Lower bits of slot which hold node index in the chunk.
+    REFHANDLE64_INDEX_BITS = sizeof( fslist_idx_t ) * 8 < REFHANDLE64_BITS
+                                 ? sizeof( fslist_idx_t ) * 8
+                                 : REFHANDLE64_BITS,
+
+    //! Tag of a node which can't be locked through compact handle.
+    REFNODE_TAG_DEAD = -1u
+};
+
+//! \brief      Reference node. Exposed only for inline handle checks.
+typedef struct refnode
+{
+    void*    ref;
+    uint32_t id;
+    uint32_t tag; // Generation of compact handle, or REFNODE_TAG_DEAD.
+    int16_t  lockcnt;
+    bool     pending_free;
+    uint8_t  slab; // Index of slab which holds ref.
+} refnode_t;
+
+//! \brief      Nodes of single chunk. Capacity covers nodes ever used, and is
+//!             0 for chunks not allocated.
+struct refpool_view
+{
+    refnode_t* nodes;
+    size_t     capacity;
+};
+
+//! \brief      Registered pool.
+struct refpool_entry
+{
+    struct refpool_view       chunks[REFPOOL_MAX_CHUNKS];
+    managed_reference_pool_t* pool;
+
+    //! Generations continue across pools using the entry, so handles of
+    //! destroyed pool don't match the next one.
+    uint32_t tagBase;
+};
+
+//! \brief      Indexed by pool id. Entry 0 is never used.
+extern struct refpool_entry g_refpool_table[REFPOOL_MAX_POOLS];
+
+/*! \brief      Size class of built-in slab allocator.
+    \details    Slab of the class holds \ref count objects of up to
+                \ref objSize bytes each, contiguously. */
+typedef struct refpool_slab_class
+{
+    size_t objSize;
+    size_t count;
+} refpool_slab_class_t;
+
 managed_reference_pool_t* refpool_create( size_t numMaxRef );
+
+/*! \brief      Create pool whose objects are served by size class slabs.
+    \details
+      Slabs are allocated in single block right after the reference node array,
+      and serve objects in O(1) without calling the allocator. Each request is
+      served by the smallest class that fits and has a free object; requests no
+      slab can serve fall back to alloc.
+    \param alloc Fallback allocator. NULL to use \ref g_mallocator.
+    \param classes Size classes, sorted by objSize in ascending order. May be
+                NULL if numClasses is 0.
+    \returns    NULL on allocation failure. */
+managed_reference_pool_t* refpool_create_ex(
+    size_t                      numMaxRef,
+    allocator_ref_t             alloc,
+    refpool_slab_class_t const* classes,
+    size_t                      numClasses );
+
+/*! \brief      Create pool which grows by chunks of numRefPerChunk nodes.
+    \details
+      First chunk is allocated along with the slabs, and following ones are
+      taken from alloc on demand, up to maxChunks. Handles encode their
+      chunk, thus remain valid across growth. See refpool_create_ex for the
+      other parameters.
+    \param maxChunks Up to REFPOOL_MAX_CHUNKS. */
+managed_reference_pool_t* refpool_create_growable(
+    size_t                      numRefPerChunk,
+    size_t                      maxChunks,
+    allocator_ref_t             alloc,
+    refpool_slab_class_t const* classes,
+    size_t                      numClasses );
+
+/*! \brief      Release trailing chunks which have no node in use. First chunk
+                is never released.
+    \returns    Number of released chunks. */
+size_t refpool_shrink( managed_reference_pool_t* s );
+
+/*! \brief      Allocate new object.
+    \returns    Handle with id OBJECTID_NULL if the pool is full and can't
+                grow, or the allocator failed. Such handle is never valid. */
 refhandle_t refpool_malloc( managed_reference_pool_t* s, size_t memsize );
-size_t      refpool_num_available( managed_reference_pool_t* s );
 
-//! \warning    This function invalidates all alive reference handles!
+//! \brief      Number of references which can be allocated, counting chunks
+//!             not allocated yet.
+size_t refpool_num_available( managed_reference_pool_t* s );
+
+/*! \warning    This function invalidates all alive reference handles!
+    \details    Pools may be created and destroyed from different threads at
+                once, unless the compiler lacks C11 atomics; then creation and
+                destruction must be serialized by the caller. */
 void refpool_destroy( managed_reference_pool_t* s );
 
 typedef void ( *refpool_foreach_callback_t )(
@@ -45,11 +169,56 @@ void refpool_foreach(
     void*                      caller,
     refpool_foreach_callback_t cb );
 
+/*! \brief      Relocate reference nodes to restore iteration locality.
+    \details    See fslist_compact. Handles of moved references change, and cb
+                is invoked with the new handle of each, which can be matched by
+                its id. Handles kept outside must be fixed up through it.
+    \warning    No reference may be locked during compaction. */
+void refpool_compact(
+    managed_reference_pool_t*  s,
+    void*                      caller,
+    refpool_foreach_callback_t cb );
+
 bool  ref_free( refhandle_t* h );
 void* ref_lock( refhandle_t* h );
 void  ref_unlock( refhandle_t* h );
 bool  ref_is_valid( refhandle_t const* h );
 
+/*! \brief      Get compact handle of the reference.
+    \returns    REFHANDLE64_NULL if the handle is stale, or its pool could not
+                be registered in g_refpool_table.
+    \warning    Compact handles are invalidated by refpool_compact, likewise.
+                Convert new handles passed to its callback again. */
+refhandle64_t ref_compact( refhandle_t const* h );
+
+static inline refnode_t* ref64_node_( refhandle64_t h )
+{
+    size_t slot = ( h >> REFHANDLE64_BITS ) & REFHANDLE64_MASK;
+    size_t idx  = slot & ( ( (size_t)1 << REFHANDLE64_INDEX_BITS ) - 1 );
+    struct refpool_view const* v
+        = &g_refpool_table[h >> 48].chunks[slot >> REFHANDLE64_INDEX_BITS];
+    return idx < v->capacity ? v->nodes + idx : NULL;
+}
+
+static inline bool ref64_is_valid( refhandle64_t h )
+{
+    refnode_t const* n = ref64_node_( h );
+    return n && n->tag == ( h & REFHANDLE64_MASK );
+}
+
+static inline void* ref64_lock( refhandle64_t h )
+{
+    refnode_t* n = ref64_node_( h );
+    if ( n == NULL || n->tag != ( h & REFHANDLE64_MASK ) )
+        return NULL;
+
+    ++n->lockcnt;
+    return n->ref;
+}
+
+void ref64_unlock( refhandle64_t h );
+bool ref64_free( refhandle64_t h );
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "radix_pqueue.h"
+#include <string.h>
+#include "bitops.h"
+#include "uassert.h"
+
+#define get_at( s, idx ) ( ( s )->buff + ( idx ) * ( s )->stride )
+#define key_of( rec ) ( *(uint64_t*)( rec ) )
+#define next_of( rec ) ( *(size_t*)( ( rec ) + sizeof( uint64_t ) ) )
+#define payload_of( rec ) ( ( rec ) + sizeof( uint64_t ) + sizeof( size_t ) )
+
+size_t radix_pqueue_init(
+    struct radix_pqueue* s,
+    size_t               elemSize,
+    void*                buff,
+    size_t               buffSize )
+{
+    size_t i;
+
+    uassert( s && buff );
+    s->elemSize = elemSize;
+    s->stride   = radix_pqueue_recordSize( elemSize );
+    s->capacity = buffSize / s->stride;
+    s->cnt      = 0;
+    s->used     = 0;
+    s->freeHead = RADIX_PQUEUE_IDX_NONE;
+    s->last     = 0;
+    s->peeked   = RADIX_PQUEUE_IDX_NONE;
+    s->occupied = 0;
+    s->buff     = buff;
+
+    for ( i = 0; i < RADIX_PQUEUE_NUM_BUCKETS; ++i )
+        s->buckets[i] = RADIX_PQUEUE_IDX_NONE;
+
+    uassert( s->capacity );
+    return s->capacity;
+}
+
+static inline unsigned bucket_of( struct radix_pqueue const* s, uint64_t key )
+{
+    return bit_width64( key ^ s->last );
+}
+
+static inline void link_bucket( struct radix_pqueue* s, size_t idx )
+{
+    char*    rec = get_at( s, idx );
+    unsigned b   = bucket_of( s, key_of( rec ) );
+
+    next_of( rec ) = s->buckets[b];
+    s->buckets[b]  = idx;
+    if ( b )
+        s->occupied |= (uint64_t)1 << ( b - 1 );
+}
+
+void radix_pqueue_push(
+    struct radix_pqueue* s,
+    uint64_t             key,
+    void const*          elem )
+{
+    size_t idx;
+    char*  rec;
+
+    uassert( s && ( elem || s->elemSize == 0 ) );
+    uassert( s->cnt < s->capacity );
+    uassert( key >= s->last );
+
+    // Recycle released record first, then take a fresh one.
+    if ( s->freeHead != RADIX_PQUEUE_IDX_NONE ) {
+        idx         = s->freeHead;
+        s->freeHead = next_of( get_at( s, idx ) );
+    }
+    else {
+        idx = s->used++;
+    }
+
+    rec           = get_at( s, idx );
+    key_of( rec ) = key;
+    if ( s->elemSize )
+        memcpy( payload_of( rec ), elem, s->elemSize );
+
+    link_bucket( s, idx );
+    s->cnt++;
+
+    if ( s->peeked != RADIX_PQUEUE_IDX_NONE
+         && key < key_of( get_at( s, s->peeked ) ) )
+        s->peeked = idx;
+}
+
+// Find the record of the smallest key in the lowest non-empty bucket.
+static size_t min_of_bucket( struct radix_pqueue const* s, unsigned b )
+{
+    size_t   idx, minIdx = RADIX_PQUEUE_IDX_NONE;
+    uint64_t minKey = UINT64_MAX;
+
+    for ( idx = s->buckets[b]; idx != RADIX_PQUEUE_IDX_NONE; ) {
+        char* rec = get_at( s, idx );
+        if ( key_of( rec ) <= minKey ) {
+            minKey = key_of( rec );
+            minIdx = idx;
+        }
+        idx = next_of( rec );
+    }
+    return minIdx;
+}
+
+// Makes bucket 0 hold every record of the smallest key.
+static void pull( struct radix_pqueue* s )
+{
+    unsigned b;
+    size_t   idx, next;
+
+    if ( s->buckets[0] != RADIX_PQUEUE_IDX_NONE )
+        return;
+
+    uassert( s->occupied );
+    b = bit_ctz64( s->occupied ) + 1;
+
+    // New minimum becomes the new base of the buckets. Peeked record is
+    // always in the lowest bucket, when there is one.
+    idx = s->peeked;
+    if ( idx == RADIX_PQUEUE_IDX_NONE )
+        idx = min_of_bucket( s, b );
+
+    // Every record of this bucket moves to the strictly lower buckets.
+    s->last       = key_of( get_at( s, idx ) );
+    idx           = s->buckets[b];
+    s->buckets[b] = RADIX_PQUEUE_IDX_NONE;
+    s->occupied &= ~( (uint64_t)1 << ( b - 1 ) );
+
+    for ( ; idx != RADIX_PQUEUE_IDX_NONE; idx = next ) {
+        next = next_of( get_at( s, idx ) );
+        link_bucket( s, idx );
+    }
+}
+
+void radix_pqueue_pop( struct radix_pqueue* s )
+{
+    size_t idx;
+
+    uassert( s && s->cnt );
+    pull( s );
+
+    idx           = s->buckets[0];
+    s->buckets[0] = next_of( get_at( s, idx ) );
+
+    next_of( get_at( s, idx ) ) = s->freeHead;
+    s->freeHead                 = idx;
+    s->peeked                   = RADIX_PQUEUE_IDX_NONE;
+    s->cnt--;
+}
+
+void* radix_pqueue_peek( struct radix_pqueue* s, uint64_t* key )
+{
+    char* rec;
+
+    uassert( s && s->cnt );
+
+    // Moving the base here would forbid keys between the last popped one and
+    // the peeked one, thus only search for the minimum.
+    if ( s->buckets[0] != RADIX_PQUEUE_IDX_NONE ) {
+        rec = get_at( s, s->buckets[0] );
+    }
+    else {
+        if ( s->peeked == RADIX_PQUEUE_IDX_NONE )
+            s->peeked = min_of_bucket( s, bit_ctz64( s->occupied ) + 1 );
+        rec = get_at( s, s->peeked );
+    }
+
+    if ( key )
+        *key = key_of( rec );
+    return payload_of( rec );
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "uassert.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! @addtogroup uEmbedded_C
+//! @{
+//! @defgroup   uEmbedded_C_RadixPriorityQueue
+//! @brief      Monotone radix heap
+//! @details
+//!              A priority queue specialized for unsigned integer keys which
+//!             are never smaller than the last popped key, e.g. timer ticks or
+//!             deadlines. Records are distributed into 65 buckets by the
+//!             highest bit that differs from the last popped key, so push is
+//!             O(1) and pop is amortized O(log C) without any comparator call.
+//!              Like \ref priority_queue, the memory is provided by the caller
+//!             and the queue never allocates by itself.
+//! @{
+
+enum
+{
+    RADIX_PQUEUE_NUM_BUCKETS = 65
+};
+
+#define RADIX_PQUEUE_IDX_NONE ( (size_t)-1 )
+
+//! \brief      Monotone radix heap.
+//! \warning    Not thread-safe!
+struct radix_pqueue
+{
+    //! \brief      Size of the payload stored with each key.
+    size_t elemSize;
+
+    //! \brief      Size of single record in buffer, including key and link.
+    size_t stride;
+
+    //! \brief      Number of queued records.
+    size_t cnt;
+
+    //! \brief      Number of maximum records.
+    size_t capacity;
+
+    //! \brief      Number of records ever taken from the buffer.
+    size_t used;
+
+    //! \brief      First released record.
+    size_t freeHead;
+
+    //! \brief      Last popped key. Pushing smaller key is not allowed.
+    //!             Buckets are distributed relative to it.
+    uint64_t last;
+
+    //! \brief      Record found by the last peek while bucket 0 was empty.
+    size_t peeked;
+
+    //! \brief      Bit N is set if bucket N + 1 is non-empty.
+    uint64_t occupied;
+
+    //! \brief      Bucket list heads.
+    size_t buckets[RADIX_PQUEUE_NUM_BUCKETS];
+
+    //! \brief
+    char* buff;
+};
+
+//! \brief      Alias for radix priority queue.
+typedef struct radix_pqueue radix_pqueue_t;
+
+//! \brief      Get number of buffer bytes required for a single record.
+static inline size_t radix_pqueue_recordSize( size_t elemSize )
+{
+    size_t sz = sizeof( uint64_t ) + sizeof( size_t ) + elemSize;
+    return ( sz + sizeof( uint64_t ) - 1 ) & ~( sizeof( uint64_t ) - 1 );
+}
+
+/*! \brief      Initialize new radix priority queue.
+    \param      buff
+                 Record buffer. Should be aligned to 8 bytes, and must be valid
+                during the queue usage.
+    \returns    Number of maximum records. */
+size_t radix_pqueue_init(
+    struct radix_pqueue* s,
+    size_t               elemSize,
+    void*                buff,
+    size_t               buffSize );
+
+/*! \brief      Push new record to queue.
+    \param      key
+                 Must be greater than or equal with the last popped key. */
+void radix_pqueue_push(
+    struct radix_pqueue* s,
+    uint64_t             key,
+    void const*          elem );
+
+/*! \brief      Pop the record with the smallest key. */
+void radix_pqueue_pop( struct radix_pqueue* s );
+
+/*! \brief      Peek the record with the smallest key.
+    \details     Buckets are not redistributed, so keys not less than the
+                last popped one can still be pushed. Result is cached until
+                the next pop, therefore the queue is not const here.
+    \param      key Optional output of record's key.
+    \returns    Pointer to record payload. */
+void* radix_pqueue_peek( struct radix_pqueue* s, uint64_t* key );
+
+//! @}
+//! @}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,87 @@
+// clock_gettime() and CLOCK_MONOTONIC are POSIX, not part of ISO C.
+#ifndef _POSIX_C_SOURCE
+#    define _POSIX_C_SOURCE 199309L
+#endif
+#include "timer_fd.h"
+#include "uassert.h"
+
+#ifdef __linux__
+#    include <sys/timerfd.h>
+#    include <time.h>
+#    include <unistd.h>
+
+bool timer_fd_init( timer_fd_t* d, uint32_t nsPerTick )
+{
+    uassert( nsPerTick );
+
+    d->fd = timerfd_create( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC );
+    d->nsPerTick = nsPerTick;
+    d->armed     = (size_t)-1;
+
+    return d->fd >= 0;
+}
+
+void timer_fd_destroy( timer_fd_t* d )
+{
+    if ( d->fd >= 0 )
+        close( d->fd );
+    d->fd = -1;
+}
+
+size_t timer_fd_now( timer_fd_t const* d )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( size_t )(
+        ( (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec )
+        / d->nsPerTick );
+}
+
+bool timer_fd_arm( timer_fd_t* d, size_t deadline )
+{
+    struct itimerspec spec = { { 0, 0 }, { 0, 0 } };
+    uint64_t          ns;
+
+    if ( deadline == d->armed )
+        return true;
+
+    if ( deadline != (size_t)-1 ) {
+        ns = (uint64_t)deadline * d->nsPerTick;
+
+        // Zero value disarms the timer. Any past time fires immediately.
+        if ( ns == 0 )
+            ns = 1;
+        spec.it_value.tv_sec  = ( time_t )( ns / 1000000000u );
+        spec.it_value.tv_nsec = ( long )( ns % 1000000000u );
+    }
+
+    // Failed call leaves the fd as it was.
+    if ( timerfd_settime( d->fd, TFD_TIMER_ABSTIME, &spec, NULL ) != 0 )
+        return false;
+
+    d->armed = deadline;
+    return true;
+}
+
+bool timer_fd_sync( timer_fd_t* d, timer_logic_t* s )
+{
+    return timer_fd_arm( d, timer_nextTrigger( s ) );
+}
+
+bool timer_fd_dispatch( timer_fd_t* d, timer_logic_t* s, size_t* next )
+{
+    uint64_t expirations;
+    size_t   nextTrig;
+
+    // Non-blocking. Fails with EAGAIN on spurious wakeup, which is harmless.
+    if ( read( d->fd, &expirations, sizeof expirations ) > 0 )
+        d->armed = (size_t)-1;
+
+    nextTrig = timer_update( s, timer_fd_now( d ) );
+    if ( next )
+        *next = nextTrig;
+    return timer_fd_arm( d, nextTrig );
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*! \brief      Tickless timerfd driver for timer logic
+    \file       timer_fd.h
+    \author     Seungwoo Kang (ki6080@gmail.com)
+    \copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+
+    \details
+      Arms single Linux timerfd on CLOCK_MONOTONIC to the earliest deadline of
+      a timer logic, so the thread can sleep in epoll until a timer is really
+      due, instead of polling timer_update at fixed rate. The fd is re-armed
+      only when the earliest deadline changes.
+      Timer ticks are CLOCK_MONOTONIC time divided by nsPerTick, which
+      timer_fd_now() returns. Available only on Linux.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "timer_logic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __linux__
+
+typedef struct timer_fd
+{
+    //! \brief      timerfd descriptor. Register it to epoll with EPOLLIN.
+    int fd;
+
+    //! \brief      Nanoseconds per tick.
+    uint32_t nsPerTick;
+
+    //! \brief      Currently armed deadline. -1 if disarmed.
+    size_t armed;
+} timer_fd_t;
+
+/*! \brief      Create non-blocking timerfd.
+    \returns    false if timerfd could not be created. */
+bool timer_fd_init( timer_fd_t* d, uint32_t nsPerTick );
+
+void timer_fd_destroy( timer_fd_t* d );
+
+/*! \brief      Get current CLOCK_MONOTONIC time in ticks. */
+size_t timer_fd_now( timer_fd_t const* d );
+
+/*! \brief      Arm fd to given absolute tick. -1 disarms it.
+    \details    Does nothing if the deadline is already armed.
+    \returns    false if timerfd_settime() failed, with errno set. The fd
+                and armed deadline are left unchanged. */
+bool timer_fd_arm( timer_fd_t* d, size_t deadline );
+
+/*! \brief      Arm fd to the next trigger time of timer logic.
+    \details    Call after adding or erasing timers outside of callbacks.
+    \returns    false if the fd could not be armed. See timer_fd_arm(). */
+bool timer_fd_sync( timer_fd_t* d, timer_logic_t* s );
+
+/*! \brief      Consume fd expiration, update timers with current time, then
+                re-arm fd. Call when fd becomes readable.
+    \param      next Optional output of next trigger time. -1 if there's no
+                timer.
+    \returns    false if the fd could not be re-armed. Timers are updated
+                anyway. See timer_fd_arm(). */
+bool timer_fd_dispatch( timer_fd_t* d, timer_logic_t* s, size_t* next );
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
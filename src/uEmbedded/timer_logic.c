@@ -1,33 +1,182 @@
 #include "timer_logic.h"
+#include "bitops.h"
 #include "uassert.h"
 
+#define info_at( s, idx ) \
+    ( (timer_info_t*)( ( s )->nodes.data + ( idx ) * ( s )->nodes.elemSize ) )
+
 size_t timer_init( timer_logic_t* s, void* buff, size_t buffSize )
 {
     size_t retval
         = fslist_init( &s->nodes, buff, buffSize, sizeof( timer_info_t ) );
-    s->idGen = 0;
+    size_t i;
+
+    s->idGen            = 0;
+    s->stats.numFired   = 0;
+    s->stats.numWakeups = 0;
+    s->periodicPolicy   = TIMER_PERIODIC_CATCH_UP;
+    s->now              = 0;
+    s->next             = (size_t)-1;
+    s->nextDirty        = false;
+
+    for ( i = 0; i < TIMER_WHEEL_LEVELS; ++i )
+        s->occupied[i] = 0;
+    for ( i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; ++i )
+        s->wheel[i] = FSLIST_NODEIDX_NONE;
+
     return retval;
 }
 
-static inline struct fslist_node* timer_find( timer_logic_t* s, size_t tick )
+//! Finds the slot that given trigger time belongs to, relative to wheel time.
+static inline uint16_t timer_slot( timer_logic_t const* s, size_t tick )
+{
+    unsigned level;
+
+    // Timers added with past time trigger on next update.
+    if ( tick < s->now )
+        tick = s->now;
+
+    level = bit_width64( tick ^ s->now );
+    level = level ? ( level - 1 ) / TIMER_WHEEL_BITS : 0;
+
+    return ( uint16_t )(
+        level * TIMER_WHEEL_SLOTS
+        + ( ( tick >> ( level * TIMER_WHEEL_BITS ) )
+            & ( TIMER_WHEEL_SLOTS - 1 ) ) );
+}
+
+//! Appends node to the back of its slot list.
+static void timer_link( timer_logic_t* s, fslist_idx_t idx )
+{
+    timer_info_t* info = info_at( s, idx );
+    uint16_t      slot = timer_slot( s, info->triggerTime );
+    fslist_idx_t* head = &s->wheel[slot];
+
+    info->wheelSlot = slot;
+
+    if ( *head == FSLIST_NODEIDX_NONE ) {
+        info->wheelPrev = info->wheelNext = idx;
+        *head                             = idx;
+        s->occupied[slot / TIMER_WHEEL_SLOTS]
+            |= (uint64_t)1 << ( slot % TIMER_WHEEL_SLOTS );
+    }
+    else {
+        timer_info_t* first = info_at( s, *head );
+        timer_info_t* last  = info_at( s, first->wheelPrev );
+
+        info->wheelPrev  = first->wheelPrev;
+        info->wheelNext  = *head;
+        last->wheelNext  = idx;
+        first->wheelPrev = idx;
+    }
+}
+
+static void timer_unlink( timer_logic_t* s, fslist_idx_t idx )
 {
-    struct fslist_node* head;
+    timer_info_t* info = info_at( s, idx );
+    fslist_idx_t* head = &s->wheel[info->wheelSlot];
 
-    if ( s->nodes.size == 0 )
-        return NULL;
+    if ( info->wheelNext == idx ) {
+        *head = FSLIST_NODEIDX_NONE;
+        s->occupied[info->wheelSlot / TIMER_WHEEL_SLOTS]
+            &= ~( (uint64_t)1 << ( info->wheelSlot % TIMER_WHEEL_SLOTS ) );
+    }
+    else {
+        info_at( s, info->wheelPrev )->wheelNext = info->wheelNext;
+        info_at( s, info->wheelNext )->wheelPrev = info->wheelPrev;
+        if ( *head == idx )
+            *head = info->wheelNext;
+    }
+
+    // Cached next trigger may belong to this timer.
+    if ( info->triggerTime <= s->next )
+        s->nextDirty = true;
+}
+
+//! Finds the timer which triggers first. Earlier added one wins on tie.
+static fslist_idx_t timer_first( timer_logic_t* s )
+{
+    unsigned     level;
+    fslist_idx_t head, it, found;
+    size_t       minTime;
 
-    head = s->nodes.get + s->nodes.head;
+    for ( level = 0; level < TIMER_WHEEL_LEVELS; ++level ) {
+        if ( s->occupied[level] == 0 )
+            continue;
 
-    while ( head ) {
-        // Finds place to insert new timer.
-        if ( ( (timer_info_t*)fslist_data( &s->nodes, head ) )->triggerTime
-             >= tick )
-            return head;
+        // Lower digit of the lowest level is always the earlier one. Only
+        // the timers in the same slot need comparison.
+        head = s->wheel
+                   [level * TIMER_WHEEL_SLOTS
+                    + bit_ctz64( s->occupied[level] )];
+        found   = head;
+        minTime = info_at( s, head )->triggerTime;
 
-        head = fslist_next( &s->nodes, head );
+        for ( it = info_at( s, head )->wheelNext; it != head;
+              it = info_at( s, it )->wheelNext ) {
+            if ( info_at( s, it )->triggerTime < minTime ) {
+                minTime = info_at( s, it )->triggerTime;
+                found   = it;
+            }
+        }
+        return found;
     }
 
-    return NULL;
+    return FSLIST_NODEIDX_NONE;
+}
+
+size_t timer_nextTrigger( timer_logic_t* s )
+{
+    fslist_idx_t idx;
+
+    if ( s->nextDirty ) {
+        idx          = timer_first( s );
+        s->next      = idx != FSLIST_NODEIDX_NONE
+                           ? info_at( s, idx )->triggerTime
+                           : (size_t)-1;
+        s->nextDirty = false;
+    }
+
+    return s->next;
+}
+
+//! Moves wheel time forward. No timer may trigger before given tick.
+static void timer_advance( timer_logic_t* s, size_t tick )
+{
+    unsigned     level;
+    uint16_t     slot;
+    fslist_idx_t head, it, next;
+
+    if ( tick <= s->now )
+        return;
+
+    level  = ( bit_width64( tick ^ s->now ) - 1 ) / TIMER_WHEEL_BITS;
+    s->now = tick;
+
+    // Every level below is empty, since they all trigger before tick.
+    // Therefore only the slot which wheel time has just entered should be
+    // cascaded down.
+    if ( level == 0 )
+        return;
+
+    slot = ( uint16_t )(
+        level * TIMER_WHEEL_SLOTS
+        + ( ( tick >> ( level * TIMER_WHEEL_BITS ) )
+            & ( TIMER_WHEEL_SLOTS - 1 ) ) );
+    head = s->wheel[slot];
+    if ( head == FSLIST_NODEIDX_NONE )
+        return;
+
+    s->wheel[slot] = FSLIST_NODEIDX_NONE;
+    s->occupied[level] &= ~( (uint64_t)1 << ( slot % TIMER_WHEEL_SLOTS ) );
+
+    // Relink in list order, to keep expiry order of same trigger time.
+    it = head;
+    do {
+        next = info_at( s, it )->wheelNext;
+        timer_link( s, it );
+        it = next;
+    } while ( it != head );
 }
 
 timer_handle_t timer_add(
@@ -40,7 +189,7 @@ timer_handle_t timer_add(
     timer_info_t*       info;
     timer_handle_t      ret;
 
-    n = fslist_insert( &s->nodes, timer_find( s, whenToTrigger ) );
+    n = fslist_insert( &s->nodes, NULL );
     uassert( n );
     uassert( callback );
 
@@ -50,37 +199,187 @@ timer_handle_t timer_add(
     info->callbackObj = callbackObj;
     info->timerId     = s->idGen++;
     info->triggerTime = whenToTrigger;
+    info->period      = 0;
+
+    timer_link( s, fslist_idx( &s->nodes, n ) );
+
+    if ( s->nextDirty == false && whenToTrigger < s->next )
+        s->next = whenToTrigger;
 
     ret.n       = n;
     ret.timerId = info->timerId;
     return ret;
 }
 
-size_t timer_update( timer_logic_t* s, size_t curTime )
+timer_handle_t timer_add_slack(
+    timer_logic_t* s,
+    size_t         whenToTrigger,
+    size_t         slack,
+    void ( *callback )( void* ),
+    void* callbackObj )
 {
-    struct fslist_node* head;
-    timer_info_t*       info;
+    size_t latest = whenToTrigger + slack;
+    size_t diff, lowBits;
+
+    if ( latest < whenToTrigger )
+        latest = (size_t)-2;
+
+    // Clearing every bit below the highest differing bit gives the value in
+    // range with the most trailing zeros, unless the lower end already has
+    // none of them set; it then has even more trailing zeros.
+    diff = whenToTrigger ^ latest;
+    if ( diff ) {
+        lowBits = ( (size_t)1 << ( bit_width64( diff ) - 1 ) ) - 1;
+        latest  = ( whenToTrigger & lowBits ) ? latest & ~lowBits
+                                              : whenToTrigger;
+    }
+
+    return timer_add( s, latest, callback, callbackObj );
+}
+
+timer_handle_t timer_add_periodic(
+    timer_logic_t* s,
+    size_t         firstTrigger,
+    size_t         period,
+    void ( *callback )( void* ),
+    void* callbackObj )
+{
+    timer_handle_t ret = timer_add( s, firstTrigger, callback, callbackObj );
+
+    uassert( period );
+    ( (timer_info_t*)fslist_data( &s->nodes, ret.n ) )->period = period;
+    return ret;
+}
+
+bool timer_erase( timer_logic_t* s, timer_handle_t h )
+{
+    if ( timer_isActive( s, h ) ) {
+        timer_unlink( s, fslist_idx( &s->nodes, h.n ) );
+        fslist_erase( &s->nodes, h.n );
+        return true;
+    }
+    else {
+        return false;
+    }
+}
+
+//! Unlinks and releases a timer, then invokes it. Periodic timers are linked
+//! again with next trigger time instead of being released.
+static void timer_fire( timer_logic_t* s, fslist_idx_t idx, size_t curTime )
+{
+    timer_info_t* info = info_at( s, idx );
     void ( *cb )( void* );
-    void* obj;
+    void*  obj;
+    size_t next;
+
+    cb  = info->callback;
+    obj = info->callbackObj;
 
-    if ( s->nodes.size == 0 )
-        return (size_t)-1;
+    timer_unlink( s, idx );
 
-    for ( ; s->nodes.head != FSLIST_NODEIDX_NONE; ) {
-        head = &s->nodes.get[s->nodes.head];
-        info = (timer_info_t*)fslist_data( &s->nodes, head );
+    if ( info->period ) {
+        next = info->triggerTime + info->period;
+        if ( s->periodicPolicy == TIMER_PERIODIC_SKIP_MISSED
+             && next <= curTime ) {
+            next += ( curTime - next ) / info->period * info->period
+                    + info->period;
+        }
+
+        info->triggerTime = next;
+        timer_link( s, idx );
+        if ( s->nextDirty == false && next < s->next )
+            s->next = next;
+    }
+    else {
+        fslist_erase( &s->nodes, s->nodes.get + idx );
+    }
+
+    ++s->stats.numFired;
+    cb( obj );
+}
+
+void timer_triggerFirst( timer_logic_t* s )
+{
+    uassert( s->nodes.size > 0 );
+    timer_fire( s, timer_first( s ), s->now );
+}
+
+size_t timer_update( timer_logic_t* s, size_t curTime )
+{
+    size_t        next;
+    size_t        numFired = s->stats.numFired;
+    fslist_idx_t* head;
+
+    for ( ;; ) {
+        next = timer_nextTrigger( s );
 
         // Timer update done.
-        if ( info->triggerTime > curTime )
-            return info->triggerTime;
+        if ( next == (size_t)-1 || next > curTime ) {
+            s->stats.numWakeups += numFired != s->stats.numFired;
+            return next;
+        }
 
-        cb  = info->callback;
-        obj = info->callbackObj;
+        // Every timer of the nearest trigger time gathers into the level 0
+        // slot of wheel time. Timers added from callbacks with past time go
+        // into the same slot, and will be fired in this loop.
+        timer_advance( s, next );
+        head = &s->wheel[timer_slot( s, s->now )];
 
-        // Erase head node
-        fslist_erase( &s->nodes, head );
-        cb( obj );
+        while ( *head != FSLIST_NODEIDX_NONE )
+            timer_fire( s, *head, curTime );
     }
+}
+
+struct compact_ctx
+{
+    timer_logic_t* s;
+    void ( *relocated )( void*, timer_handle_t const* );
+    void* caller;
+};
+
+static void timer_relocated( void* obj, fslist_idx_t from, fslist_idx_t to )
+{
+    struct compact_ctx* ctx = obj;
+    timer_handle_t      h;
+
+    (void)from;
+    h.n       = ctx->s->nodes.get + to;
+    h.timerId = info_at( ctx->s, to )->timerId;
+    ctx->relocated( ctx->caller, &h );
+}
+
+void timer_compact(
+    timer_logic_t* s,
+    void ( *relocated )( void*, timer_handle_t const* ),
+    void* caller )
+{
+    struct compact_ctx ctx;
+    timer_info_t*      info;
+    fslist_idx_t       idx, pos;
+    size_t             i;
+
+    // n-th element of the list moves to index n. Wheel links are rewritten
+    // into list positions beforehand, so each slot keeps its chain order,
+    // which differs from the list order once timers are relinked by firing
+    // or cascading. Prev link temporarily holds position of the node itself.
+    for ( pos = 0, idx = s->nodes.head; idx != FSLIST_NODEIDX_NONE;
+          ++pos, idx = s->nodes.get[idx].next )
+        info_at( s, idx )->wheelPrev = pos;
+    for ( idx = s->nodes.head; idx != FSLIST_NODEIDX_NONE;
+          idx = s->nodes.get[idx].next ) {
+        info = info_at( s, idx );
+        info->wheelNext = info_at( s, info->wheelNext )->wheelPrev;
+    }
+    for ( i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; ++i ) {
+        if ( s->wheel[i] != FSLIST_NODEIDX_NONE )
+            s->wheel[i] = info_at( s, s->wheel[i] )->wheelPrev;
+    }
+
+    ctx.s         = s;
+    ctx.relocated = relocated;
+    ctx.caller    = caller;
+    fslist_compact( &s->nodes, relocated ? timer_relocated : NULL, &ctx );
 
-    return (size_t)-1;
+    for ( idx = 0; idx < s->nodes.size; ++idx )
+        info_at( s, info_at( s, idx )->wheelNext )->wheelPrev = idx;
 }
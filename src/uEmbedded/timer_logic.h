@@ -13,12 +13,75 @@ extern "C" {
 //! @addtogroup     uEmbedded_C
 //! @{
 //! @defgroup       uEmbedded_C_Timer_Logic
+//! @details
+//!              Timers are kept in a hierarchical timing wheel. Each level
+//!             holds TIMER_WHEEL_SLOTS lists, and a timer is placed in the
+//!             level of the highest digit where its trigger time differs from
+//!             the wheel's current time. Slots are cascaded down to lower
+//!             levels only when the wheel time moves into them, therefore
+//!             adding and erasing timers are O(1), and timers sharing a trigger
+//!             time expire in the order they were added.
+//!              Timer entries are stored in the fslist pool, and the wheel
+//!             links them by fslist node indexes.
 //! @{
+#ifndef TIMER_WHEEL_BITS
+#    define TIMER_WHEEL_BITS 6
+#endif
+
+// Slot occupancy of each level is a 64 bit mask.
+#if TIMER_WHEEL_BITS < 1 || TIMER_WHEEL_BITS > 6
+#    error "TIMER_WHEEL_BITS must be in range of 1 to 6"
+#endif
+
+enum
+{
+    TIMER_WHEEL_SLOTS  = 1 << TIMER_WHEEL_BITS,
+    TIMER_WHEEL_LEVELS = ( sizeof( size_t ) * 8 + TIMER_WHEEL_BITS - 1 )
+                         / TIMER_WHEEL_BITS
+};
+
+//! \brief      Timer statistics, to observe the effect of coalescing.
+struct timer_stats
+{
+    //! \brief      Number of fired callbacks.
+    size_t numFired;
+
+    //! \brief      Number of timer_update() calls that fired any timer.
+    size_t numWakeups;
+};
+
+//! \brief      How periodic timers handle the periods missed by late update.
+enum timer_periodic_policy
+{
+    //! Fire once for every missed period.
+    TIMER_PERIODIC_CATCH_UP,
+
+    //! Fire once, then skip to the first period after update time.
+    TIMER_PERIODIC_SKIP_MISSED
+};
 
 struct timer_logic
 {
-    struct fslist nodes;
-    size_t        idGen;
+    struct fslist      nodes;
+    size_t             idGen;
+    struct timer_stats stats;
+
+    //! \brief      One of \ref timer_periodic_policy. Default is catch-up.
+    uint8_t periodicPolicy;
+
+    //! \brief      Wheel time. Every timer triggers at or after this time,
+    //!             except the ones added with past time.
+    size_t now;
+
+    //! \brief      Cached result of timer_nextTrigger()
+    size_t next;
+    bool   nextDirty;
+
+    //! \brief      Bit N of each level is set when slot N is not empty.
+    uint64_t occupied[TIMER_WHEEL_LEVELS];
+
+    //! \brief      Heads of circular slot lists
+    fslist_idx_t wheel[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
 };
 
 struct timer_logic_info
@@ -27,6 +90,14 @@ struct timer_logic_info
     size_t triggerTime;
     void ( *callback )( void* );
     void* callbackObj;
+
+    //! \brief      Period of periodic timer. 0 if it's one-shot.
+    size_t period;
+
+    //! \brief      Links of the wheel slot list. For internal use.
+    fslist_idx_t wheelPrev;
+    fslist_idx_t wheelNext;
+    uint16_t     wheelSlot;
 };
 
 enum // Required to allocate buffer for size
@@ -55,21 +126,39 @@ timer_handle_t timer_add(
     void ( *callback )( void* ),
     void* callbackObj );
 
+//! \brief      Allocates new timer which may be delayed up to given slack.
+//! \details
+//!              The timer triggers at the time with the most trailing zero
+//!             bits within [whenToTrigger, whenToTrigger + slack], so timers
+//!             with overlapping ranges tend to share the same trigger time, and
+//!             the wheel is woken up less.
+timer_handle_t timer_add_slack(
+    timer_logic_t* s,
+    size_t         whenToTrigger,
+    size_t         slack,
+    void ( *callback )( void* ),
+    void* callbackObj );
+
+//! \brief      Allocates new periodic timer.
+//! \details
+//!              The timer is rescheduled in place from its ideal trigger time
+//!             each time it fires, thus keeps its handle and doesn't drift by
+//!             callback latency. Missed periods are handled as
+//!             timer_logic::periodicPolicy specifies. Erase it to stop.
+timer_handle_t timer_add_periodic(
+    timer_logic_t* s,
+    size_t         firstTrigger,
+    size_t         period,
+    void ( *callback )( void* ),
+    void* callbackObj );
+
 //! \brief      Update timer based on given time parameter.
 //! @returns    Next trigger time. -1 if there's no more timer to trigger.
 size_t timer_update( timer_logic_t* s, size_t curTime );
 
 //! \brief      Get closest timer's trigger time
-static inline size_t timer_nextTrigger( timer_logic_t* s )
-{
-    if ( s->nodes.size == 0 ) {
-        return (size_t)-1;
-    }
-
-    return ( (timer_info_t*)
-                 fslist_data( &s->nodes, s->nodes.get + s->nodes.head ) )
-        ->triggerTime;
-}
+//! @returns    -1 if there's no timer.
+size_t timer_nextTrigger( timer_logic_t* s );
 
 //! \brief      Browse timer handle
 static inline timer_info_t const*
@@ -90,34 +179,26 @@ static inline bool timer_isActive( timer_logic_t* s, timer_handle_t h )
 }
 
 //! \brief      Remove allcoated timer.
-static inline bool timer_erase( timer_logic_t* s, timer_handle_t h )
+bool timer_erase( timer_logic_t* s, timer_handle_t h );
+
+//! \brief      Number of wakeups saved, compared to waking up once per timer.
+static inline size_t timer_wakeupsSaved( timer_logic_t const* s )
 {
-    if ( timer_isActive( s, h ) ) {
-        fslist_erase( &s->nodes, h.n );
-        return true;
-    }
-    else {
-        return false;
-    }
+    return s->stats.numFired - s->stats.numWakeups;
 }
 
 //! \breif      Trigger first timer unconditionally.
-static inline void timer_triggerFirst( timer_logic_t* s )
-{
-    struct fslist_node* head;
-    timer_info_t*       info;
-
-    uassert( s->nodes.size > 0 );
-
-    head = &s->nodes.get[s->nodes.head];
-
-    void ( *cb )( void* ) = info->callback;
-    void* obj             = info->callbackObj;
-
-    fslist_erase( &s->nodes, head );
-
-    cb( obj );
-}
+void timer_triggerFirst( timer_logic_t* s );
+
+//! \brief      Relocate timer nodes to restore memory locality.
+//! \details    See fslist_compact. The handle of every moved timer changes,
+//!             and relocated is invoked with its new handle, which can be
+//!             matched by timerId. Handles kept outside must be fixed up
+//!             through it. Can be NULL.
+void timer_compact(
+    timer_logic_t* s,
+    void ( *relocated )( void*, timer_handle_t const* ),
+    void* caller );
 
 //! @}
 //! @}
@@ -0,0 +1,305 @@
+#include "timer_service.h"
+#include "fslist_cpool.h"
+#include "uassert.h"
+
+#ifndef __STDC_NO_ATOMICS__
+#    include <stdatomic.h>
+
+enum
+{
+    CACHE_LINE = 64,
+    CMD_ADD    = 0,
+    CMD_CANCEL = 1
+};
+
+struct command
+{
+    atomic_size_t seq;
+    int           type;
+    uint32_t      slot;
+    uint32_t      gen;
+    size_t        when;
+    void ( *cb )( void* );
+    void* obj;
+};
+
+//! Stable identity of a timer requested through service. Owner thread writes
+//! every field except gen.
+struct slot
+{
+    atomic_uint_least32_t gen;
+    struct shard*         owner;
+    timer_handle_t        local;
+    void ( *cb )( void* );
+    void* obj;
+};
+
+struct shard
+{
+    fslist_cpool_t* freeSlots;
+    char            pad0[CACHE_LINE];
+
+    atomic_size_t enqueuePos;
+    char          pad1[CACHE_LINE];
+
+    // Fields below are accessed only by the owner thread, except the arrays.
+    size_t          dequeuePos;
+    size_t          queueMask;
+    struct command* queue;
+    struct slot*    slots;
+    void*           timerBuff;
+    timer_logic_t   timers;
+    char            pad2[CACHE_LINE];
+};
+
+struct timer_service
+{
+    size_t        numShards;
+    struct shard* shards;
+};
+
+static void slot_release( struct slot* sl )
+{
+    struct shard* sh = sl->owner;
+
+    atomic_fetch_add_explicit( &sl->gen, 1, memory_order_release );
+    fslist_cpool_push( sh->freeSlots, ( uint32_t )( sl - sh->slots ) );
+}
+
+static bool cmd_push( struct shard* sh, struct command const* cmd )
+{
+    struct command* cell;
+    size_t          pos;
+    size_t          seq;
+    intptr_t        dif;
+
+    pos = atomic_load_explicit( &sh->enqueuePos, memory_order_relaxed );
+    for ( ;; ) {
+        cell = &sh->queue[pos & sh->queueMask];
+        seq  = atomic_load_explicit( &cell->seq, memory_order_acquire );
+        dif  = (intptr_t)seq - (intptr_t)pos;
+
+        if ( dif == 0 ) {
+            if ( atomic_compare_exchange_weak_explicit(
+                     &sh->enqueuePos,
+                     &pos,
+                     pos + 1,
+                     memory_order_relaxed,
+                     memory_order_relaxed ) )
+                break;
+        }
+        else if ( dif < 0 ) {
+            return false; // Queue is full
+        }
+        else {
+            pos = atomic_load_explicit(
+                &sh->enqueuePos, memory_order_relaxed );
+        }
+    }
+
+    cell->type = cmd->type;
+    cell->slot = cmd->slot;
+    cell->gen  = cmd->gen;
+    cell->when = cmd->when;
+    cell->cb   = cmd->cb;
+    cell->obj  = cmd->obj;
+    atomic_store_explicit( &cell->seq, pos + 1, memory_order_release );
+    return true;
+}
+
+static void timer_trampoline( void* obj )
+{
+    struct slot* sl       = obj;
+    void ( *cb )( void* ) = sl->cb;
+    void* cbObj           = sl->obj;
+
+    slot_release( sl );
+    cb( cbObj );
+}
+
+static void shard_drain( struct shard* sh )
+{
+    struct command* cell;
+    struct slot*    sl;
+
+    for ( ;; ) {
+        cell = &sh->queue[sh->dequeuePos & sh->queueMask];
+        if ( atomic_load_explicit( &cell->seq, memory_order_acquire )
+             != sh->dequeuePos + 1 )
+            break;
+
+        sl = &sh->slots[cell->slot];
+
+        if ( cell->type == CMD_ADD ) {
+            sl->cb    = cell->cb;
+            sl->obj   = cell->obj;
+            sl->local = timer_add(
+                &sh->timers, cell->when, timer_trampoline, sl );
+        }
+        else if (
+            atomic_load_explicit( &sl->gen, memory_order_relaxed ) == cell->gen
+            && timer_erase( &sh->timers, sl->local ) ) {
+            slot_release( sl );
+        }
+
+        atomic_store_explicit(
+            &cell->seq,
+            sh->dequeuePos + sh->queueMask + 1,
+            memory_order_release );
+        ++sh->dequeuePos;
+    }
+}
+
+static void shards_release( timer_service_t* s, size_t numShards )
+{
+    size_t i;
+
+    for ( i = 0; i < numShards; ++i ) {
+        free( s->shards[i].timerBuff );
+        free( s->shards[i].slots );
+        free( s->shards[i].queue );
+        if ( s->shards[i].freeSlots )
+            fslist_cpool_destroy( s->shards[i].freeSlots );
+    }
+    free( s->shards );
+    free( s );
+}
+
+timer_service_t*
+timer_service_create( size_t numShards, size_t numTimers, size_t queueSize )
+{
+    timer_service_t* s;
+    struct shard*    sh;
+    size_t           i, k, queueCap;
+
+    uassert( numShards && numTimers && queueSize );
+    uassert( numTimers < (uint32_t)TIMER_SERVICE_SLOT_NONE );
+
+    for ( queueCap = 1; queueCap < queueSize; queueCap <<= 1 )
+        ;
+
+    s = malloc( sizeof( timer_service_t ) );
+    if ( s == NULL )
+        return NULL;
+
+    s->numShards = numShards;
+    s->shards    = calloc( numShards, sizeof( struct shard ) );
+    if ( s->shards == NULL ) {
+        free( s );
+        return NULL;
+    }
+
+    for ( i = 0; i < numShards; ++i ) {
+        sh             = &s->shards[i];
+        sh->timerBuff  = malloc( numTimers * TIMER_ELEM_SIZE );
+        sh->slots      = malloc( numTimers * sizeof( struct slot ) );
+        sh->queue      = malloc( queueCap * sizeof( struct command ) );
+        sh->queueMask  = queueCap - 1;
+        sh->dequeuePos = 0;
+        sh->freeSlots  = fslist_cpool_create( (uint32_t)numTimers );
+        if ( !sh->timerBuff || !sh->slots || !sh->queue || !sh->freeSlots ) {
+            shards_release( s, i + 1 );
+            return NULL;
+        }
+
+        k = timer_init(
+            &sh->timers, sh->timerBuff, numTimers * TIMER_ELEM_SIZE );
+        uassert( k == numTimers );
+
+        for ( k = 0; k < numTimers; ++k ) {
+            sh->slots[k].owner = sh;
+            atomic_init( &sh->slots[k].gen, 0 );
+        }
+
+        for ( k = 0; k < queueCap; ++k )
+            atomic_init( &sh->queue[k].seq, k );
+        atomic_init( &sh->enqueuePos, 0 );
+    }
+
+    return s;
+}
+
+void timer_service_destroy( timer_service_t* s )
+{
+    shards_release( s, s->numShards );
+}
+
+timer_service_handle_t timer_service_add(
+    timer_service_t* s,
+    size_t           shard,
+    size_t           whenToTrigger,
+    void ( *callback )( void* ),
+    void* callbackObj )
+{
+    struct shard*          sh;
+    struct command         cmd;
+    timer_service_handle_t ret;
+
+    uassert( s && shard < s->numShards && callback );
+    sh        = &s->shards[shard];
+    ret.shard = (uint32_t)shard;
+    ret.slot  = fslist_cpool_pop( sh->freeSlots );
+    ret.gen   = 0;
+
+    if ( ret.slot == (uint32_t)TIMER_SERVICE_SLOT_NONE )
+        return ret;
+
+    ret.gen = atomic_load_explicit(
+        &sh->slots[ret.slot].gen, memory_order_relaxed );
+
+    cmd.type = CMD_ADD;
+    cmd.slot = ret.slot;
+    cmd.gen  = ret.gen;
+    cmd.when = whenToTrigger;
+    cmd.cb   = callback;
+    cmd.obj  = callbackObj;
+
+    if ( !cmd_push( sh, &cmd ) ) {
+        fslist_cpool_push( sh->freeSlots, ret.slot );
+        ret.slot = (uint32_t)TIMER_SERVICE_SLOT_NONE;
+    }
+
+    return ret;
+}
+
+bool timer_service_cancel( timer_service_t* s, timer_service_handle_t h )
+{
+    struct shard*  sh;
+    struct command cmd;
+
+    uassert( s );
+    if ( h.shard >= s->numShards
+         || h.slot == (uint32_t)TIMER_SERVICE_SLOT_NONE )
+        return false;
+
+    sh = &s->shards[h.shard];
+    if ( atomic_load_explicit( &sh->slots[h.slot].gen, memory_order_acquire )
+         != h.gen )
+        return false;
+
+    cmd.type = CMD_CANCEL;
+    cmd.slot = h.slot;
+    cmd.gen  = h.gen;
+    cmd.when = 0;
+    cmd.cb   = NULL;
+    cmd.obj  = NULL;
+    return cmd_push( sh, &cmd );
+}
+
+size_t timer_service_update( timer_service_t* s, size_t shard, size_t curTime )
+{
+    struct shard* sh;
+
+    uassert( s && shard < s->numShards );
+    sh = &s->shards[shard];
+
+    shard_drain( sh );
+    return timer_update( &sh->timers, curTime );
+}
+
+size_t timer_service_numShards( timer_service_t const* s )
+{
+    return s->numShards;
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*! \brief      Sharded timer service
+    \file       timer_service.h
+    \author     Seungwoo Kang (ki6080@gmail.com)
+    \copyright  Copyright (c) 2019. Seungwoo Kang. All rights reserved.
+
+    \details
+      Runs one timer_logic_t per shard, where each shard is owned by single
+      thread. Any thread can add or cancel a timer of any shard; requests are
+      delivered through a lock-free MPSC command queue of the shard, and the
+      owner thread applies them before firing its timers. Therefore no lock is
+      shared between shards.
+      Requires C11 atomics.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "timer_logic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum
+{
+    TIMER_SERVICE_SLOT_NONE = -1
+};
+
+typedef struct timer_service timer_service_t;
+
+//! \brief      Handle of the timer added through service. Encodes its shard.
+typedef struct timer_service_handle
+{
+    uint32_t shard;
+    uint32_t slot;
+    uint32_t gen;
+} timer_service_handle_t;
+
+/*! \brief      Create new timer service.
+    \param      numTimers Number of maximum timers of each shard.
+    \param      queueSize
+                 Number of command queue entries of each shard. Rounded up to
+                power of 2.
+    \returns    NULL if any allocation fails. */
+timer_service_t*
+timer_service_create( size_t numShards, size_t numTimers, size_t queueSize );
+
+//! \warning    All shard threads must be stopped before.
+void timer_service_destroy( timer_service_t* s );
+
+/*! \brief      Request new timer on given shard. Thread-safe.
+    \returns    Handle with slot TIMER_SERVICE_SLOT_NONE when the shard has no
+                room for new timer, or its command queue is full. */
+timer_service_handle_t timer_service_add(
+    timer_service_t* s,
+    size_t           shard,
+    size_t           whenToTrigger,
+    void ( *callback )( void* ),
+    void* callbackObj );
+
+/*! \brief      Request cancellation of timer. Thread-safe.
+    \returns    false if the timer was already fired or cancelled, or the
+                command queue is full. Returning true does not guarantee the
+                cancellation, since the timer may fire before the owner thread
+                handles the request. */
+bool timer_service_cancel( timer_service_t* s, timer_service_handle_t h );
+
+/*! \brief      Apply pending requests, then update timers of the shard.
+    \warning    Must be called only by the owner thread of the shard.
+    \returns    Next trigger time of the shard. -1 if there's no timer. */
+size_t timer_service_update( timer_service_t* s, size_t shard, size_t curTime );
+
+/*! \brief      Get number of shards */
+size_t timer_service_numShards( timer_service_t const* s );
+
+#ifdef __cplusplus
+}
+#endif
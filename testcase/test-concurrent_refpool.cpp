@@ -0,0 +1,133 @@
+#include <Catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+extern "C" {
+#include <uEmbedded/concurrent_reference_pool.h>
+}
+
+namespace {
+struct counting_allocator
+{
+    allocator_t     a;
+    std::atomic_int live { 0 };
+
+    counting_allocator()
+    {
+        a.object   = this;
+        a.allocate = []( void* c, size_t sz ) {
+            ++static_cast<counting_allocator*>( c )->live;
+            return malloc( sz );
+        };
+        a.release = []( void* c, void* mem ) {
+            --static_cast<counting_allocator*>( c )->live;
+            free( mem );
+        };
+    }
+};
+} // namespace
+
+TEST_CASE( "Concurrent refpool", "[concurrent_refpool]" )
+{
+    enum
+    {
+        CAP = 64
+    };
+    counting_allocator alloc;
+    auto               p = crefpool_create( CAP, &alloc.a );
+
+    SECTION( "Single thread" )
+    {
+        std::vector<crefhandle_t> hd;
+        for ( int i = 0; i < CAP; ++i ) {
+            hd.push_back( crefpool_malloc( p, sizeof( int ) ) );
+            *(int*)cref_lock( &hd.back() ) = i;
+            cref_unlock( &hd.back() );
+        }
+        REQUIRE( crefpool_num_available( p ) == 0 );
+        REQUIRE( crefpool_malloc( p, 4 ).slot == (uint32_t)CREF_SLOT_NONE );
+
+        int sum = 0;
+        crefpool_foreach( p, &sum, []( void* c, crefhandle_t const* h ) {
+            *(int*)c += *(int*)cref_lock( h );
+            cref_unlock( h );
+        } );
+        REQUIRE( sum == CAP * ( CAP - 1 ) / 2 );
+
+        // Pinned object outlives free, but the handle is invalidated at once.
+        auto obj = cref_lock( &hd[3] );
+        REQUIRE( cref_free( &hd[3] ) );
+        REQUIRE_FALSE( cref_free( &hd[3] ) );
+        REQUIRE_FALSE( cref_is_valid( &hd[3] ) );
+        REQUIRE( cref_lock( &hd[3] ) == nullptr );
+        REQUIRE( *(int*)obj == 3 );
+        REQUIRE( alloc.live == CAP );
+        cref_unlock( &hd[3] );
+        REQUIRE( alloc.live == CAP - 1 );
+
+        // Reused slot doesn't revive stale handle.
+        auto h = crefpool_malloc( p, 4 );
+        REQUIRE( h.slot == hd[3].slot );
+        REQUIRE( cref_is_valid( &h ) );
+        REQUIRE_FALSE( cref_is_valid( &hd[3] ) );
+    }
+
+    SECTION( "Shared handles" )
+    {
+        enum
+        {
+            NUM_THREADS = 8,
+            NUM_ROUNDS  = 20000
+        };
+        // Cells hold slot and generation of shared handles.
+        auto make = [&]( uint64_t v ) {
+            return crefhandle_t { p, uint32_t( v >> 32 ), uint32_t( v ) };
+        };
+        auto publish = [&]( std::atomic<uint64_t>& cell ) {
+            auto h = crefpool_malloc( p, sizeof( int ) );
+            if ( h.slot == (uint32_t)CREF_SLOT_NONE )
+                return;
+            *(int*)cref_lock( &h ) = 42;
+            cref_unlock( &h );
+            cell = uint64_t( h.slot ) << 32 | h.gen;
+        };
+
+        std::vector<std::atomic<uint64_t>> shared( 16 );
+        for ( auto& s : shared )
+            publish( s );
+
+        std::atomic_int          corrupt { 0 };
+        std::vector<std::thread> threads;
+        for ( int t = 0; t < NUM_THREADS; ++t ) {
+            threads.emplace_back( [&, t] {
+                for ( int r = 0; r < NUM_ROUNDS; ++r ) {
+                    auto& cell = shared[( r * 7 + t ) % shared.size()];
+                    auto  h    = make( cell.load() );
+
+                    // Pinned object must not be released under the reader.
+                    if ( auto obj = (int*)cref_lock( &h ) ) {
+                        corrupt += *obj != 42;
+                        cref_unlock( &h );
+                    }
+
+                    // Occasionally replace the object under other readers.
+                    if ( r % 5 == t % 5 && cref_free( &h ) )
+                        publish( cell );
+                }
+            } );
+        }
+        for ( auto& t : threads )
+            t.join();
+
+        REQUIRE( corrupt == 0 );
+        for ( auto& s : shared ) {
+            auto h = make( s.load() );
+            cref_free( &h );
+        }
+        REQUIRE( alloc.live == 0 );
+        REQUIRE( crefpool_num_available( p ) == CAP );
+    }
+
+    crefpool_destroy( p );
+    REQUIRE( alloc.live == 0 );
+}
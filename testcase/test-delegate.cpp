@@ -1,4 +1,6 @@
 #include <Catch2/catch.hpp>
+#include <chrono>
+#include <vector>
 extern "C"
 {
 #include <uEmbedded/delegate.h>
@@ -39,4 +41,236 @@ TEST_CASE("delegate test", "[delegate_pool]")
     REQUIRE(v == 15);
 
     delegate_destroy(evnt);
-}
\ No newline at end of file
+}
+TEST_CASE("delegate storage", "[delegate_pool]")
+{
+    enum { NUM_SUBS = 1000 };
+    auto p = refpool_create(NUM_SUBS);
+    auto d = delegate_create(true);
+
+    std::vector<refhandle> hd;
+    for ( int i = 0; i < NUM_SUBS; ++i )
+    {
+        hd.push_back(refpool_malloc(p, sizeof(int)));
+        *(int*) ref_lock(&hd.back()) = i;
+        ref_unlock(&hd.back());
+        delegate_assign(d, &hd.back(), [] (refhandle const* h, void* v) {
+            auto& seq = *(std::vector<int>*) v;
+            seq.push_back(*(int*) ref_lock((refhandle*) h));
+            ref_unlock((refhandle*) h);
+        });
+    }
+    REQUIRE(delegate_size(d) == NUM_SUBS);
+
+    // Called in order of assignment; expired references are dropped.
+    for ( int i = 0; i < NUM_SUBS; i += 2 )
+        ref_free(&hd[i]);
+
+    std::vector<int> seq;
+    delegate_call(d, &seq);
+    REQUIRE(seq.size() == NUM_SUBS / 2);
+    for ( size_t i = 0; i < seq.size(); ++i )
+        REQUIRE(seq[i] == int(i * 2 + 1));
+    REQUIRE(delegate_size(d) == NUM_SUBS / 2);
+
+    seq.clear();
+    delegate_call(d, &seq);
+    REQUIRE(seq.size() == NUM_SUBS / 2);
+
+    delegate_clear(d);
+    REQUIRE(delegate_size(d) == 0);
+    seq.clear();
+    delegate_call(d, &seq);
+    REQUIRE(seq.empty());
+
+    delegate_destroy(d);
+    refpool_destroy(p);
+}
+
+TEST_CASE("delegate assign during call", "[delegate_pool]")
+{
+    struct ctx
+    {
+        delegate_t* d;
+        refhandle   h;
+        int         calls = 0;
+    } c;
+
+    auto p = refpool_create(4);
+    c.d    = delegate_create(true);
+    c.h    = refpool_malloc(p, sizeof(int));
+
+    // Each call subscribes again, which grows the array past inline storage.
+    static delegate_event_cb_t const cb = [] (refhandle const*, void* v) {
+        auto& c = *(ctx*) v;
+        ++c.calls;
+        delegate_assign(c.d, &c.h, cb);
+    };
+    delegate_assign(c.d, &c.h, cb);
+
+    int expect = 0;
+    for ( int n = 1; n <= 64; n *= 2 )
+    {
+        delegate_call(c.d, &c);
+        expect += n;
+        REQUIRE(c.calls == expect);
+        REQUIRE(delegate_size(c.d) == size_t(n * 2));
+    }
+
+    // Every duplicate of (object, callback) is removed at once.
+    REQUIRE(delegate_delete(c.d, &c.h, cb) == 128);
+    REQUIRE(delegate_size(c.d) == 0);
+
+    delegate_destroy(c.d);
+    refpool_destroy(p);
+}
+
+TEST_CASE("delegate subscription handle", "[delegate_pool]")
+{
+    enum { NUM_SUBS = 100 };
+    auto p = refpool_create(1);
+    auto d = delegate_create(true);
+    auto h = refpool_malloc(p, sizeof(int));
+
+    static delegate_event_cb_t const count = [] (refhandle const*, void* v) {
+        ++*(int*) v;
+    };
+
+    std::vector<delegate_handle_t> subs;
+    for ( int i = 0; i < NUM_SUBS; ++i )
+        subs.push_back(delegate_assign(d, &h, count));
+
+    for ( int i = 0; i < NUM_SUBS; i += 2 )
+        REQUIRE(delegate_unsubscribe(d, subs[i]));
+    REQUIRE_FALSE(delegate_unsubscribe(d, subs[0]));
+    REQUIRE_FALSE(delegate_unsubscribe(d, DELEGATE_HANDLE_NONE));
+    REQUIRE(delegate_size(d) == NUM_SUBS / 2);
+
+    int n = 0;
+    delegate_call(d, &n);
+    REQUIRE(n == NUM_SUBS / 2);
+
+    // Reused slots don't revive stale handles.
+    auto again = delegate_assign(d, &h, count);
+    REQUIRE(again != subs[0]);
+    REQUIRE_FALSE(delegate_unsubscribe(d, subs[0]));
+
+    // Handles of remaining subscriptions survive compaction.
+    for ( int i = 1; i < NUM_SUBS; i += 2 )
+        REQUIRE(delegate_unsubscribe(d, subs[i]));
+    REQUIRE(delegate_size(d) == 1);
+
+    // Removal by (object, callback) invalidates the handle as well.
+    REQUIRE(delegate_delete(d, &h, count) == 1);
+    REQUIRE_FALSE(delegate_unsubscribe(d, again));
+    delegate_destroy(d);
+
+    // Single cast delegate replaces its subscription.
+    d          = delegate_create(false);
+    auto first = delegate_assign(d, &h, count);
+    auto next  = delegate_assign(d, &h, count);
+    REQUIRE(delegate_size(d) == 1);
+    REQUIRE_FALSE(delegate_unsubscribe(d, first));
+    REQUIRE(delegate_unsubscribe(d, next));
+    REQUIRE(delegate_size(d) == 0);
+    delegate_destroy(d);
+
+    refpool_destroy(p);
+}
+
+TEST_CASE("delegate unsubscribe during call", "[delegate_pool]")
+{
+    struct ctx
+    {
+        delegate_t*                    d;
+        std::vector<delegate_handle_t> subs;
+        int                            calls = 0;
+    } c;
+
+    auto p = refpool_create(1);
+    auto h = refpool_malloc(p, sizeof(int));
+    c.d    = delegate_create(true);
+
+    // First callback removes every other subscription, including itself.
+    for ( int i = 0; i < 10; ++i )
+    {
+        c.subs.push_back(delegate_assign(
+          c.d, &h, [] (refhandle const*, void* v) {
+              auto& c = *(ctx*) v;
+              if ( c.calls++ == 0 )
+                  for ( size_t i = 0; i < c.subs.size(); i += 2 )
+                      delegate_unsubscribe(c.d, c.subs[i]);
+          }));
+    }
+
+    delegate_call(c.d, &c);
+    REQUIRE(c.calls == 6);
+    REQUIRE(delegate_size(c.d) == 5);
+    for ( size_t i = 1; i < c.subs.size(); i += 2 )
+        REQUIRE(delegate_unsubscribe(c.d, c.subs[i]));
+
+    delegate_destroy(c.d);
+    refpool_destroy(p);
+}
+
+TEST_CASE("delegate call benchmark", "[delegate_pool][.benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+    enum { NUM_SUBS = 10000, NUM_ROUNDS = 100 };
+    auto p = refpool_create(NUM_SUBS);
+    auto d = delegate_create(true);
+
+    for ( int i = 0; i < NUM_SUBS; ++i )
+    {
+        auto h = refpool_malloc(p, sizeof(int));
+        delegate_assign(d, &h, [] (refhandle const*, void* v) {
+            ++*(size_t*) v;
+        });
+    }
+
+    size_t n  = 0;
+    auto   t0 = clock::now();
+    for ( int r = 0; r < NUM_ROUNDS; ++r )
+        delegate_call(d, &n);
+    auto t1 = clock::now();
+
+    using ns = std::chrono::duration<double, std::nano>;
+    REQUIRE(n == size_t(NUM_SUBS) * NUM_ROUNDS);
+    WARN(ns(t1 - t0).count() / n << "ns/subscriber");
+
+    delegate_destroy(d);
+    refpool_destroy(p);
+}
+
+TEST_CASE("delegate churn benchmark", "[delegate_pool][.benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+    enum { NUM_SUBS = 10000, NUM_CHURN = 100000 };
+    auto p = refpool_create(1);
+    auto d = delegate_create(true);
+    auto h = refpool_malloc(p, sizeof(int));
+    auto cb = [] (refhandle const*, void*) {};
+
+    std::vector<delegate_handle_t> subs;
+    for ( int i = 0; i < NUM_SUBS; ++i )
+        subs.push_back(delegate_assign(d, &h, cb));
+
+    // Replace random subscriptions one by one.
+    uint32_t rand = 1;
+    auto     t0   = clock::now();
+    for ( int i = 0; i < NUM_CHURN; ++i )
+    {
+        rand    = rand * 1103515245 + 12345;
+        auto& s = subs[( rand >> 8 ) % NUM_SUBS];
+        delegate_unsubscribe(d, s);
+        s = delegate_assign(d, &h, cb);
+    }
+    auto t1 = clock::now();
+
+    using ns = std::chrono::duration<double, std::nano>;
+    REQUIRE(delegate_size(d) == NUM_SUBS);
+    WARN(ns(t1 - t0).count() / NUM_CHURN << "ns/churn");
+
+    delegate_destroy(d);
+    refpool_destroy(p);
+}
@@ -1,10 +1,15 @@
 #include <Catch2/catch.hpp>
 #include <algorithm>
+#include <atomic>
 #include <list>
+#include <set>
 
 extern "C" {
 #include <uEmbedded/fslist.h>
 }
+#include <uEmbedded-pp/dynamic_fslist.hxx>
+#include <uEmbedded-pp/fslist_parallel.hxx>
+#include <uEmbedded-pp/shared_fslist.hxx>
 #include <uEmbedded-pp/static_fslist.hxx>
 int v;
 
@@ -106,4 +111,486 @@ TEST_CASE( "fslist Cplusplus version", "[fslist]" )
     }
 
     REQUIRE( std::equal( v.begin(), v.end(), f.begin(), f.end() ) );
-}
\ No newline at end of file
+}
+TEST_CASE( "fslist lazy initialization", "[fslist]" )
+{
+    fslist            v;
+    std::vector<char> buff( 64 * ( FSLIST_NODE_SIZE + sizeof( int ) ), 0x5a );
+
+    size_t cnt = fslist_init( &v, buff.data(), buff.size(), sizeof( int ) );
+    REQUIRE( cnt == 64 );
+    REQUIRE( v.hwm == 0 );
+
+    // Buffer is not touched by init.
+    REQUIRE( std::all_of(
+      buff.begin(), buff.end(), []( char c ) { return c == 0x5a; } ) );
+
+    auto a = fslist_insert( &v, NULL );
+    auto b = fslist_insert( &v, NULL );
+    REQUIRE( fslist_idx( &v, a ) == 0 );
+    REQUIRE( fslist_idx( &v, b ) == 1 );
+    REQUIRE( v.hwm == 2 );
+
+    // Released node is reused before the never used ones.
+    fslist_erase( &v, a );
+    REQUIRE( fslist_insert( &v, NULL ) == a );
+    REQUIRE( v.hwm == 2 );
+
+    for ( size_t i = 2; i < cnt; ++i )
+        fslist_insert( &v, NULL );
+    REQUIRE( v.size == cnt );
+    REQUIRE( v.hwm == cnt );
+
+    SECTION( "C++ version" )
+    {
+        upp::static_fslist<int, uint16_t, 8> f;
+
+        auto it = f.insert( f.end(), 1 );
+        f.push_back( 2 );
+        REQUIRE( f.at__( 2 ) == nullptr );
+
+        f.erase( it );
+        REQUIRE( f.at__( 0 ) == nullptr );
+        f.push_back( 3 );
+        REQUIRE( f.at__( 0 ) != nullptr );
+        REQUIRE( f.front() == 2 );
+        REQUIRE( f.back() == 3 );
+    }
+}
+
+namespace {
+struct counted_t
+{
+    static inline int num_alive = 0;
+
+    explicit counted_t( int v ) noexcept : v_( v ) { ++num_alive; }
+    counted_t( counted_t const& r ) noexcept : v_( r.v_ ) { ++num_alive; }
+    ~counted_t() noexcept { --num_alive; }
+
+    int v_;
+};
+
+upp::static_fslist<int, uint16_t, 4096> g_static_list;
+} // namespace
+
+TEST_CASE( "static_fslist storage", "[fslist]" )
+{
+    SECTION( "Elements are constructed only on insertion" )
+    {
+        {
+            upp::static_fslist<counted_t, uint16_t, 64> f;
+            REQUIRE( counted_t::num_alive == 0 );
+
+            f.emplace_back( 1 );
+            f.emplace_front( 2 );
+            REQUIRE( counted_t::num_alive == 2 );
+
+            f.pop_back();
+            REQUIRE( counted_t::num_alive == 1 );
+
+            f.emplace_back( 3 );
+        }
+        REQUIRE( counted_t::num_alive == 0 );
+    }
+
+    SECTION( "Trivial elements are cleared at once" )
+    {
+        for ( int i = 0; i < 100; ++i )
+            g_static_list.push_back( i );
+
+        g_static_list.clear();
+        REQUIRE( g_static_list.empty() );
+        REQUIRE( g_static_list.begin() == g_static_list.end() );
+
+        g_static_list.push_back( 7 );
+        REQUIRE( g_static_list.front() == 7 );
+        REQUIRE( g_static_list.size() == 1 );
+        g_static_list.clear();
+    }
+}
+
+TEST_CASE( "dynamic_fslist growth", "[fslist]" )
+{
+    upp::dynamic_fslist<counted_t, uint16_t, 4> f;
+    REQUIRE( f.capacity() == 0 );
+    REQUIRE( f.max_size() == 65535 / 16 * 16 );
+
+    f.emplace_back( 0 );
+    auto  first     = f.begin();
+    auto* first_ptr = &f.front();
+    REQUIRE( f.capacity() == 16 );
+
+    for ( int i = 1; i < 100; ++i )
+        f.emplace_back( i );
+    REQUIRE( f.capacity() == 112 );
+    REQUIRE( counted_t::num_alive == 100 );
+
+    // Values never move on growth.
+    REQUIRE( &*first == first_ptr );
+    REQUIRE( first->v_ == 0 );
+
+    int expect = 0;
+    for ( auto& v : f )
+        REQUIRE( v.v_ == expect++ );
+
+    SECTION( "Shrink releases trailing chunks only" )
+    {
+        for ( int i = 0; i < 60; ++i )
+            f.pop_back();
+        f.shrink_to_fit();
+        REQUIRE( f.capacity() == 48 );
+        REQUIRE( &*first == first_ptr );
+
+        // Released nodes of kept chunks are reused before growing again.
+        for ( int i = 40; i < 48; ++i )
+            f.emplace_back( i );
+        REQUIRE( f.capacity() == 48 );
+        f.emplace_back( 48 );
+        REQUIRE( f.capacity() == 64 );
+        REQUIRE( f.back().v_ == 48 );
+        REQUIRE( f.size() == 49 );
+
+        f.clear();
+        f.shrink_to_fit();
+        REQUIRE( f.capacity() == 0 );
+        f.emplace_front( 1 );
+        REQUIRE( f.front().v_ == 1 );
+    }
+
+    SECTION( "Reserve" )
+    {
+        REQUIRE( f.reserve( 1000 ) );
+        REQUIRE( f.capacity() == 1008 );
+        REQUIRE( &*first == first_ptr );
+    }
+
+    SECTION( "Shared list grows the pool" )
+    {
+        upp::shared_fslist<counted_t, uint16_t, true> s( f );
+        for ( int i = 0; i < 20; ++i )
+            s.emplace_back( 100 + i );
+        REQUIRE( f.capacity() == 128 );
+        REQUIRE( s.size() == 20 );
+        REQUIRE( s.back().v_ == 119 );
+        REQUIRE( &*first == first_ptr );
+    }
+}
+
+TEST_CASE( "fslist insertion into full list", "[fslist]" )
+{
+    SECTION( "Static list" )
+    {
+        upp::static_fslist<counted_t, uint16_t, 4> f;
+        for ( int i = 0; i < 4; ++i )
+            REQUIRE( f.try_emplace_back( i ) );
+
+        REQUIRE( f.try_emplace_back( 4 ) == nullptr );
+        REQUIRE( f.try_emplace_front( 4 ) == nullptr );
+        REQUIRE( f.emplace( f.begin(), 4 ) == f.end() );
+        REQUIRE( f.size() == 4 );
+        REQUIRE( counted_t::num_alive == 4 );
+
+        f.pop_front();
+        REQUIRE( f.try_emplace_front( 5 )->v_ == 5 );
+    }
+
+    SECTION( "Dynamic list which can't grow any more" )
+    {
+        upp::dynamic_fslist<counted_t, uint8_t, 4> f;
+        for ( size_t i = 0; i < f.max_size(); ++i )
+            REQUIRE( f.try_emplace_back( int( i ) ) );
+
+        REQUIRE( f.capacity() == 240 );
+        REQUIRE( f.try_emplace_back( 0 ) == nullptr );
+        REQUIRE( f.emplace( f.end(), 0 ) == f.end() );
+        REQUIRE( f.size() == 240 );
+        REQUIRE( f.back().v_ == 239 );
+    }
+    REQUIRE( counted_t::num_alive == 0 );
+}
+
+TEST_CASE( "fslist compaction", "[fslist]" )
+{
+    fslist            v;
+    std::vector<char> buff( 256 * ( FSLIST_NODE_SIZE + sizeof( int ) ) );
+    size_t cnt = fslist_init( &v, buff.data(), buff.size(), sizeof( int ) );
+
+    std::vector<fslist_idx_t> where( 10000, FSLIST_NODEIDX_NONE );
+    std::vector<int>          expect;
+    int                       gen = 0;
+
+    for ( int round = 0; round < 20; ++round ) {
+        // Churn the list with inserts and erases at random places.
+        while ( v.size < cnt ) {
+            auto at = v.size && rand() % 2 ? v.get + v.head : NULL;
+            auto n  = fslist_insert( &v, at );
+            *(int*)fslist_data( &v, n ) = gen;
+            where[gen++]                = fslist_idx( &v, n );
+        }
+        for ( size_t i = 0; i < cnt / 2; ++i ) {
+            auto n = v.get + v.head;
+            for ( int k = rand() % 8; k-- && fslist_next( &v, n ); )
+                n = fslist_next( &v, n );
+            fslist_erase( &v, n );
+        }
+
+        expect.clear();
+        for ( auto n = v.get + v.head; n; n = fslist_next( &v, n ) )
+            expect.push_back( *(int*)fslist_data( &v, n ) );
+
+        // Every element is reported at most once, from its original index.
+        std::vector<fslist_idx_t> remap( cnt );
+        for ( size_t i = 0; i < cnt; ++i )
+            remap[i] = (fslist_idx_t)i;
+
+        fslist_compact(
+          &v,
+          []( void* c, fslist_idx_t from, fslist_idx_t to ) {
+              auto& r = *(std::vector<fslist_idx_t>*)c;
+              REQUIRE( r[from] == from );
+              r[from] = to;
+          },
+          &remap );
+
+        REQUIRE( v.hwm == v.size );
+        REQUIRE( v.inactive == FSLIST_NODEIDX_NONE );
+
+        size_t i = 0;
+        for ( auto n = v.get + v.head; n; n = fslist_next( &v, n ), ++i ) {
+            REQUIRE( fslist_idx( &v, n ) == i );
+            REQUIRE( *(int*)fslist_data( &v, n ) == expect[i] );
+            REQUIRE( remap[where[expect[i]]] == i );
+            where[expect[i]] = (fslist_idx_t)i;
+        }
+        REQUIRE( i == expect.size() );
+        REQUIRE( fslist_idx( &v, v.get + v.tail ) == i - 1 );
+    }
+}
+
+TEST_CASE( "fslist_base defragment", "[fslist]" )
+{
+    upp::static_fslist<counted_t, uint16_t, 128> f;
+    std::vector<int>                             expect;
+
+    for ( int i = 0; i < 128; ++i )
+        i % 3 ? f.emplace_back( i ) : f.emplace_front( i );
+    for ( auto it = f.begin(); it != f.end(); ) {
+        auto cur = it;
+        ++it;
+        if ( cur->v_ % 4 == 1 )
+            f.erase( cur );
+    }
+    for ( int i = 0; i < 20; ++i )
+        f.emplace( f.begin(), 1000 + i );
+
+    for ( auto& v : f )
+        expect.push_back( v.v_ );
+    auto const alive = counted_t::num_alive;
+
+    std::vector<uint16_t> remap( 128 );
+    for ( size_t i = 0; i < remap.size(); ++i )
+        remap[i] = uint16_t( i );
+    auto origin_of_front = f.begin().fs_idx__();
+
+    f.defragment( [&]( uint16_t from, uint16_t to ) {
+        REQUIRE( remap[from] == from );
+        remap[from] = to;
+    } );
+
+    REQUIRE( counted_t::num_alive == alive );
+    REQUIRE( remap[origin_of_front] == 0 );
+
+    uint16_t i = 0;
+    for ( auto it = f.begin(); it != f.end(); ++it, ++i ) {
+        REQUIRE( it.fs_idx__() == i );
+        REQUIRE( it->v_ == expect[i] );
+    }
+    REQUIRE( i == f.size() );
+
+    // Pool keeps working after defragmentation.
+    f.pop_front();
+    f.emplace_back( -1 );
+    REQUIRE( f.back().v_ == -1 );
+}
+
+TEST_CASE( "fslist splice, merge and sort", "[fslist]" )
+{
+    upp::static_fslist<std::pair<int, int>, size_t, 64> pool;
+    upp::shared_fslist<std::pair<int, int>>     a( pool ), b( pool );
+    auto by_key = []( auto& x, auto& y ) { return x.first < y.first; };
+
+    for ( int i = 0; i < 8; ++i )
+        a.emplace_back( i * 2, 0 );
+    for ( int i = 0; i < 8; ++i )
+        b.emplace_back( i * 2, 1 );
+    REQUIRE( pool.empty() );
+    REQUIRE( pool.pool_size() == 16 );
+
+    SECTION( "Stable merge keeps element addresses" )
+    {
+        auto p = &b.front();
+        a.merge( b, by_key );
+        REQUIRE( b.empty() );
+        REQUIRE( a.size() == 16 );
+
+        int i = 0;
+        for ( auto& v : a ) {
+            REQUIRE( v.first == i / 2 * 2 );
+            REQUIRE( v.second == i % 2 );
+            ++i;
+        }
+        REQUIRE( &*std::next( a.begin() ) == p );
+    }
+
+    SECTION( "Splice between pool and shared list" )
+    {
+        pool.splice( pool.end(), a );
+        REQUIRE( a.empty() );
+        REQUIRE( pool.size() == 8 );
+
+        b.splice( b.begin(), pool, pool.begin() );
+        REQUIRE( b.size() == 9 );
+        REQUIRE( b.front().first == 0 );
+        REQUIRE( b.front().second == 0 );
+
+        b.splice( b.end(), pool, pool.begin(), std::next( pool.begin(), 3 ) );
+        REQUIRE( b.size() == 12 );
+        REQUIRE( pool.size() == 4 );
+        REQUIRE( b.back().first == 6 );
+
+        // Range within the same list
+        b.splice( b.begin(), b, std::next( b.begin(), 9 ), b.end() );
+        REQUIRE( b.size() == 12 );
+        REQUIRE( b.front().first == 2 );
+        REQUIRE( pool.pool_size() == 16 );
+    }
+
+    SECTION( "Sort relinks nodes without moving values" )
+    {
+        std::vector<std::pair<int, int>*> addr;
+        for ( int i = 0; i < 40; ++i )
+            addr.push_back( &pool.emplace_back( ( i * 7 ) % 10, i ) );
+
+        pool.sort( by_key );
+        REQUIRE( pool.size() == 40 );
+
+        auto it = pool.begin();
+        for ( int i = 1; i < 40; ++i ) {
+            auto prv = it;
+            ++it;
+            REQUIRE( prv->first <= it->first );
+            if ( prv->first == it->first )
+                REQUIRE( prv->second < it->second );
+        }
+        for ( int i = 0; i < 40; ++i )
+            REQUIRE( addr[i]->second == i );
+
+        // Reverse traversal must see the same order.
+        auto last = std::prev( pool.end() );
+        REQUIRE( last->first == 9 );
+        REQUIRE( std::prev( last )->first == 9 );
+    }
+
+    SECTION( "Shared lists draw from pool capacity" )
+    {
+        while ( pool.pool_size() < pool.max_size() )
+            b.emplace_back( -1, -1 );
+        REQUIRE( pool.size() == 0 );
+        REQUIRE( b.size() == 56 );
+
+        b.clear();
+        a.clear();
+        REQUIRE( pool.pool_size() == 0 );
+        pool.emplace_back( 1, 1 );
+        REQUIRE( pool.size() == 1 );
+    }
+}
+
+TEST_CASE( "fslist occupancy bitmap", "[fslist]" )
+{
+    SECTION( "C version" )
+    {
+        size_t constexpr          CAP = 1000;
+        fslist                    s;
+        std::vector<char>         buf( CAP * ( 4 + FSLIST_NODE_SIZE ) );
+        std::vector<uint64_t>     bits( FSLIST_LIVE_WORDS( CAP ), ~0ull );
+        std::vector<fslist_node*> nodes;
+
+        fslist_init( &s, buf.data(), buf.size(), sizeof( int ) );
+        for ( int i = 0; i < 100; ++i )
+            nodes.push_back( fslist_insert( &s, NULL ) );
+        fslist_attachLiveBits( &s, bits.data() );
+
+        for ( int i = 100; i < 700; ++i )
+            nodes.push_back( fslist_insert( &s, i % 2 ? NULL : nodes[0] ) );
+        for ( int i = 0; i < 700; i += 3 )
+            fslist_erase( &s, nodes[i] );
+        for ( int i = 0; i < 700; ++i )
+            *(int*)fslist_data( &s, nodes[i] ) = i;
+
+        std::set<int> expect;
+        for ( int i = 0; i < 700; ++i ) {
+            if ( i % 3 )
+                expect.insert( i );
+        }
+
+        auto collect = []( void* caller, fslist_idx_t idx, void* elem ) {
+            auto v = *(int*)elem;
+            REQUIRE( v == idx );
+            static_cast<std::set<int>*>( caller )->insert( v );
+        };
+
+        std::set<int> visited;
+        fslist_forEachLive( &s, collect, &visited );
+        REQUIRE( visited == expect );
+
+        fslist_compact( &s, NULL, NULL );
+        REQUIRE( fslist_liveWords( &s ) == FSLIST_LIVE_WORDS( s.size ) );
+
+        size_t cnt = 0;
+        fslist_forEachLive(
+          &s,
+          []( void* caller, fslist_idx_t, void* ) { ++*(size_t*)caller; },
+          &cnt );
+        REQUIRE( cnt == s.size );
+    }
+
+    SECTION( "C++ version" )
+    {
+        upp::dynamic_fslist<int, uint32_t, 6> f;
+        std::vector<upp::dynamic_fslist<int, uint32_t, 6>::iterator> its;
+
+        for ( int i = 0; i < 5000; ++i )
+            its.push_back( f.emplace( f.begin(), i ) );
+        for ( int i = 0; i < 5000; i += 2 )
+            f.erase( its[i] );
+
+        int64_t sum = 0;
+        f.for_each_live( [&]( int v ) { sum += v; } );
+        REQUIRE( sum == 2500ll * 2500 );
+
+        // Erase while visiting
+        f.for_each_live( [&]( int& v ) {
+            if ( v % 4 == 1 )
+                f.erase( its[v] );
+        } );
+        REQUIRE( f.size() == 1250 );
+
+        std::atomic<int64_t> psum { 0 };
+        upp::for_each_live_parallel(
+          f, [&]( int v ) { psum += v; }, 4 );
+
+        int64_t expect = 0;
+        for ( auto v : f )
+            expect += v;
+        REQUIRE( psum == expect );
+
+        f.defragment();
+        f.shrink_to_fit();
+        REQUIRE( f.live_words() == ( f.size() + 63 ) / 64 );
+
+        psum = 0;
+        upp::for_each_live_parallel( f, [&]( int v ) { psum += v; }, 3 );
+        REQUIRE( psum == expect );
+    }
+}
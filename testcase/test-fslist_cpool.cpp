@@ -0,0 +1,150 @@
+#include <Catch2/catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+extern "C" {
+#include <uEmbedded/fslist_cpool.h>
+}
+
+TEST_CASE( "Concurrent node index pool", "[fslist-cpool]" )
+{
+    enum
+    {
+        CAP         = 1000,
+        NUM_THREADS = 8,
+        NUM_ROUNDS  = 20000
+    };
+    auto p = fslist_cpool_create( CAP );
+    REQUIRE( fslist_cpool_capacity( p ) == CAP );
+
+    SECTION( "Single thread" )
+    {
+        std::vector<uint32_t> taken;
+        for ( uint32_t i = 0; i < CAP; ++i )
+            taken.push_back( fslist_cpool_pop( p ) );
+        REQUIRE( fslist_cpool_pop( p ) == (uint32_t)FSLIST_CPOOL_NONE );
+
+        std::sort( taken.begin(), taken.end() );
+        for ( uint32_t i = 0; i < CAP; ++i )
+            REQUIRE( taken[i] == i );
+
+        fslist_cpool_pushBatch( p, taken.data(), 10 );
+        uint32_t out[16];
+        REQUIRE( fslist_cpool_popBatch( p, out, 16 ) == 10 );
+        REQUIRE( out[0] == 0 );
+        REQUIRE( out[9] == 9 );
+    }
+
+    SECTION( "Every index is owned by single thread at a time" )
+    {
+        std::unique_ptr<std::atomic_int[]> owner( new std::atomic_int[CAP] );
+        for ( int i = 0; i < CAP; ++i )
+            owner[i] = -1;
+
+        std::atomic_int          conflicts { 0 };
+        std::vector<std::thread> threads;
+        for ( int t = 0; t < NUM_THREADS; ++t ) {
+            threads.emplace_back( [&, t] {
+                fslist_magazine_t     m = {};
+                std::vector<uint32_t> held;
+
+                for ( int r = 0; r < NUM_ROUNDS; ++r ) {
+                    // Odd threads bypass magazines to mix both paths.
+                    auto idx = t % 2 ? fslist_cpool_pop( p )
+                                     : fslist_magazine_alloc( &m, p );
+                    if ( idx != (uint32_t)FSLIST_CPOOL_NONE ) {
+                        int expect = -1;
+                        conflicts += !owner[idx].compare_exchange_strong(
+                          expect, t );
+                        held.push_back( idx );
+                    }
+
+                    if ( held.size() > 20 || ( r % 3 == 0 && held.size() ) ) {
+                        auto i = held.back();
+                        held.pop_back();
+                        owner[i] = -1;
+                        t % 2 ? fslist_cpool_push( p, i )
+                              : fslist_magazine_free( &m, p, i );
+                    }
+                }
+
+                for ( auto i : held ) {
+                    owner[i] = -1;
+                    fslist_cpool_push( p, i );
+                }
+                fslist_magazine_flush( &m, p );
+            } );
+        }
+        for ( auto& t : threads )
+            t.join();
+
+        REQUIRE( conflicts == 0 );
+
+        // Every index returned to the pool.
+        uint32_t n = 0;
+        while ( fslist_cpool_pop( p ) != (uint32_t)FSLIST_CPOOL_NONE )
+            ++n;
+        REQUIRE( n == CAP );
+    }
+
+    fslist_cpool_destroy( p );
+}
+
+TEST_CASE(
+  "Concurrent node index pool benchmark", "[fslist-cpool][.benchmark]" )
+{
+    using clock = std::chrono::steady_clock;
+    enum
+    {
+        CAP      = 1 << 16,
+        NUM_OPS  = 1 << 20,
+        HOLD_MAX = 64
+    };
+
+    for ( bool magazine : { false, true } ) {
+        for ( int nt : { 1, 2, 4, 8, 16, 32 } ) {
+            auto p = fslist_cpool_create( CAP );
+
+            auto t0 = clock::now();
+            std::vector<std::thread> threads;
+            for ( int t = 0; t < nt; ++t ) {
+                threads.emplace_back( [&] {
+                    fslist_magazine_t m = {};
+                    uint32_t          held[HOLD_MAX];
+                    int               cnt = 0;
+
+                    for ( int i = 0; i < NUM_OPS / nt; ++i ) {
+                        if ( cnt < HOLD_MAX && ( i & 1 ) == 0 ) {
+                            held[cnt++] = magazine
+                                            ? fslist_magazine_alloc( &m, p )
+                                            : fslist_cpool_pop( p );
+                        }
+                        else if ( cnt ) {
+                            --cnt;
+                            magazine ? fslist_magazine_free( &m, p, held[cnt] )
+                                     : fslist_cpool_push( p, held[cnt] );
+                        }
+                    }
+                    fslist_cpool_pushBatch( p, held, cnt );
+                    fslist_magazine_flush( &m, p );
+                } );
+            }
+            for ( auto& t : threads )
+                t.join();
+            auto t1 = clock::now();
+
+            WARN(
+              ( magazine ? "magazine " : "shared   " )
+              << nt << " threads: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   t1 - t0 )
+                     .count()
+                   / NUM_OPS
+              << "ns/op" );
+            fslist_cpool_destroy( p );
+        }
+    }
+}
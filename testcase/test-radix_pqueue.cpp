@@ -0,0 +1,144 @@
+#include <Catch2/catch.hpp>
+#include <chrono>
+#include <random>
+#include <vector>
+extern "C" {
+#include "uEmbedded/priority_queue.h"
+#include "uEmbedded/radix_pqueue.h"
+}
+
+TEST_CASE( "Radix priority queue", "[radix_pqueue]" )
+{
+    radix_pqueue_t s;
+    std::vector<uint64_t> buff( 0x10000 );
+    auto cap = radix_pqueue_init(
+      &s, sizeof( uint32_t ), buff.data(), buff.size() * sizeof( uint64_t ) );
+
+    REQUIRE( cap == s.capacity );
+    REQUIRE( cap == 0x10000 * 8 / radix_pqueue_recordSize( 4 ) );
+
+    std::mt19937_64 mt( 1 );
+
+    SECTION( "Pops in key order" )
+    {
+        for ( uint32_t i = 0; i < cap; i++ ) {
+            radix_pqueue_push( &s, mt() >> ( mt() & 63 ), &i );
+        }
+        REQUIRE( s.cnt == cap );
+
+        uint64_t prev = 0, key;
+        while ( s.cnt ) {
+            radix_pqueue_peek( &s, &key );
+            REQUIRE( prev <= key );
+            prev = key;
+            radix_pqueue_pop( &s );
+        }
+    }
+
+    SECTION( "Monotone push while popping" )
+    {
+        std::vector<uint64_t> shadow;
+        uint64_t              now = 0;
+
+        for ( uint32_t i = 0; i < cap / 2; i++ ) {
+            uint64_t k = now + mt() % 1000;
+            radix_pqueue_push( &s, k, &i );
+            shadow.push_back( k );
+        }
+
+        for ( size_t i = 0; i < 100000; ++i ) {
+            auto m = std::min_element( shadow.begin(), shadow.end() );
+            radix_pqueue_peek( &s, &now );
+            REQUIRE( now == *m );
+            radix_pqueue_pop( &s );
+
+            *m = now + mt() % 1000;
+            radix_pqueue_push( &s, *m, &i );
+        }
+        REQUIRE( s.cnt == cap / 2 );
+    }
+
+    SECTION( "Peek doesn't forbid earlier keys" )
+    {
+        uint64_t key;
+        uint32_t v = 10;
+        radix_pqueue_push( &s, 10, &v );
+        REQUIRE( *(uint32_t*)radix_pqueue_peek( &s, &key ) == 10 );
+        REQUIRE( key == 10 );
+
+        v = 5;
+        radix_pqueue_push( &s, 5, &v );
+        REQUIRE( *(uint32_t*)radix_pqueue_peek( &s, &key ) == 5 );
+        REQUIRE( key == 5 );
+
+        v = 7;
+        radix_pqueue_push( &s, 7, &v );
+        radix_pqueue_pop( &s );
+        REQUIRE( *(uint32_t*)radix_pqueue_peek( &s, &key ) == 7 );
+
+        // Keys between the last popped and the peeked one are still allowed.
+        v = 6;
+        radix_pqueue_push( &s, 6, &v );
+        radix_pqueue_pop( &s );
+        REQUIRE( *(uint32_t*)radix_pqueue_peek( &s, &key ) == 7 );
+        radix_pqueue_pop( &s );
+        REQUIRE( *(uint32_t*)radix_pqueue_peek( &s, &key ) == 10 );
+        radix_pqueue_pop( &s );
+        REQUIRE( s.cnt == 0 );
+    }
+}
+
+TEST_CASE( "Radix priority queue benchmark", "[radix_pqueue][.benchmark]" )
+{
+    using clock = std::chrono::steady_clock;
+    auto usec   = []( clock::duration d ) {
+        return std::chrono::duration_cast<std::chrono::microseconds>( d )
+          .count();
+    };
+    auto pred = []( void const* a, void const* b ) -> int {
+        auto l = *(uint64_t const*)a, r = *(uint64_t const*)b;
+        return l < r ? -1 : l > r;
+    };
+
+    for ( size_t n : { 1000, 10000, 100000, 1000000, 10000000 } ) {
+        std::mt19937_64       mt( n );
+        std::vector<uint64_t> keys( n );
+        for ( auto& k : keys )
+            k = mt() % ( n * 16 );
+
+        std::vector<uint64_t> hbuf( n ), rbuf( n * 2 );
+        pqueue_t              h;
+        radix_pqueue_t        r;
+        pqueue_init( &h, sizeof( uint64_t ), hbuf.data(), n * 8, pred );
+        radix_pqueue_init( &r, 0, rbuf.data(), n * 16 );
+
+        // Fill with random deadlines, then run hold operations that pop the
+        // earliest one and re-arm it later, as a timer queue does.
+        auto t0 = clock::now();
+        for ( auto k : keys )
+            pqueue_push( &h, &k );
+        for ( size_t i = 0; i < n; ++i ) {
+            auto k = *(uint64_t*)pqueue_peek( &h ) + keys[i] % 1024;
+            pqueue_pop( &h );
+            pqueue_push( &h, &k );
+        }
+        while ( h.cnt )
+            pqueue_pop( &h );
+        auto t1 = clock::now();
+        for ( auto k : keys )
+            radix_pqueue_push( &r, k, NULL );
+        for ( size_t i = 0; i < n; ++i ) {
+            uint64_t k;
+            radix_pqueue_peek( &r, &k );
+            radix_pqueue_pop( &r );
+            radix_pqueue_push( &r, k + keys[i] % 1024, NULL );
+        }
+        while ( r.cnt )
+            radix_pqueue_pop( &r );
+        auto t2 = clock::now();
+
+        WARN(
+          n << " entries: binary heap " << usec( t1 - t0 ) << "us, radix heap "
+            << usec( t2 - t1 ) << "us" );
+    }
+}
@@ -1,4 +1,8 @@
 #include <Catch2/catch.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 extern "C"
 {
 #include <uEmbedded/managed_reference_pool.h>
@@ -47,4 +51,355 @@ TEST_CASE("refpool test", "[managed_reference_pool]")
     REQUIRE(refpool_num_available(p));
 
     refpool_destroy(p);
-}
\ No newline at end of file
+}
+TEST_CASE("refpool compaction", "[managed_reference_pool]")
+{
+    enum { NUM_REF = 1000 };
+    auto p = refpool_create(NUM_REF);
+
+    std::vector<refhandle_t> hd(NUM_REF);
+    for ( int i = 0; i < NUM_REF; ++i )
+    {
+        hd[i] = refpool_malloc(p, sizeof(int));
+        *(int*) ( ref_lock(&hd[i]) ) = i;
+        ref_unlock(&hd[i]);
+    }
+    for ( int i = 0; i < NUM_REF; i += 3 )
+        ref_free(&hd[i]);
+
+    auto stale = hd;
+
+    // Handles are looked up by id, which equals to index in this test.
+    refpool_compact(p, &hd, [] (void* c, refhandle_t* h) {
+        ( *(std::vector<refhandle_t>*) c )[h->id] = *h;
+    });
+
+    for ( int i = 0; i < NUM_REF; ++i )
+    {
+        if ( i % 3 == 0 )
+        {
+            REQUIRE_FALSE(ref_is_valid(&hd[i]));
+            continue;
+        }
+
+        REQUIRE(*(int*) ref_lock(&hd[i]) == i);
+        ref_unlock(&hd[i]);
+
+        // Old handle of moved reference no longer resolves.
+        if ( stale[i].node != hd[i].node )
+            REQUIRE_FALSE(ref_is_valid(&stale[i]));
+    }
+
+    // Iteration sweeps nodes in memory order.
+    fslist_node* prev = nullptr;
+    refpool_foreach(p, &prev, [] (void* c, auto h) {
+        auto& prev = *(fslist_node**) c;
+        REQUIRE(( prev == nullptr || h->node == prev + 1 ));
+        prev = h->node;
+    });
+
+    refpool_destroy(p);
+}
+TEST_CASE("refpool slab allocator", "[managed_reference_pool]")
+{
+    struct counter
+    {
+        allocator_t a;
+        int         live = 0;
+    } fallback;
+    fallback.a.object   = &fallback;
+    fallback.a.allocate = [] (void* c, size_t sz) {
+        ++( (counter*) c )->live;
+        return malloc(sz);
+    };
+    fallback.a.release = [] (void* c, void* mem) {
+        --( (counter*) c )->live;
+        free(mem);
+    };
+
+    refpool_slab_class_t classes[] = { { 12, 4 }, { 40, 2 } };
+    auto p = refpool_create_ex(16, &fallback.a, classes, 2);
+
+    refhandle_t small[4], big[2];
+    char*       addr[4];
+    for ( int i = 0; i < 4; ++i )
+    {
+        small[i] = refpool_malloc(p, 12);
+        addr[i]  = (char*) ref_lock(&small[i]);
+        ref_unlock(&small[i]);
+    }
+
+    // Objects of same class are contiguous.
+    for ( int i = 1; i < 4; ++i )
+        REQUIRE(addr[i] - addr[i - 1] == 16);
+
+    // Small class is exhausted, next class serves it; then fallback does.
+    big[0] = refpool_malloc(p, 8);
+    big[1] = refpool_malloc(p, 40);
+    REQUIRE(fallback.live == 0);
+    auto spill = refpool_malloc(p, 8);
+    auto huge  = refpool_malloc(p, 1000);
+    REQUIRE(fallback.live == 2);
+
+    // Released slab object is reused first.
+    ref_free(&small[2]);
+    auto again = refpool_malloc(p, 4);
+    REQUIRE(ref_lock(&again) == addr[2]);
+    ref_unlock(&again);
+
+    // Deferred free goes back to the slab as well.
+    ref_lock(&small[1]);
+    ref_free(&small[1]);
+    REQUIRE(fallback.live == 2);
+    ref_unlock(&small[1]);
+    auto again2 = refpool_malloc(p, 12);
+    REQUIRE(ref_lock(&again2) == addr[1]);
+    ref_unlock(&again2);
+
+    ref_free(&huge);
+    REQUIRE(fallback.live == 1);
+    (void) spill;
+    (void) big;
+
+    refpool_destroy(p);
+    REQUIRE(fallback.live == 0);
+}
+TEST_CASE("refpool compact handle", "[managed_reference_pool]")
+{
+    static_assert(sizeof(refhandle64_t) == 8, "");
+    enum { NUM_REF = 100 };
+    auto p = refpool_create(NUM_REF);
+
+    std::vector<refhandle64_t> hd;
+    for ( int i = 0; i < NUM_REF; ++i )
+    {
+        auto h = refpool_malloc(p, sizeof(int));
+        *(int*) ref_lock(&h) = i;
+        ref_unlock(&h);
+        hd.push_back(ref_compact(&h));
+        REQUIRE(hd.back() != REFHANDLE64_NULL);
+    }
+    REQUIRE_FALSE(ref64_is_valid(REFHANDLE64_NULL));
+
+    for ( int i = 0; i < NUM_REF; ++i )
+    {
+        REQUIRE(*(int*) ref64_lock(hd[i]) == i);
+        ref64_unlock(hd[i]);
+    }
+
+    // Free while locked defers release; handle is invalid right away.
+    auto obj = ref64_lock(hd[5]);
+    REQUIRE(ref64_free(hd[5]));
+    REQUIRE_FALSE(ref64_is_valid(hd[5]));
+    REQUIRE(ref64_lock(hd[5]) == nullptr);
+    REQUIRE(*(int*) obj == 5);
+    ref64_unlock(hd[5]);
+    REQUIRE(refpool_num_available(p) == 1);
+    REQUIRE_FALSE(ref64_free(hd[5]));
+
+    // Reused node doesn't revive the stale handle.
+    auto h = refpool_malloc(p, sizeof(int));
+    auto c = ref_compact(&h);
+    REQUIRE(c != hd[5]);
+    REQUIRE(ref64_is_valid(c));
+    REQUIRE_FALSE(ref64_is_valid(hd[5]));
+
+    // Handles of destroyed pool never match the next pool on same entry.
+    refpool_destroy(p);
+    REQUIRE_FALSE(ref64_is_valid(c));
+
+    p = refpool_create(NUM_REF);
+    for ( int i = 0; i < NUM_REF; ++i )
+        refpool_malloc(p, sizeof(int));
+    for ( auto old : hd )
+        REQUIRE_FALSE(ref64_is_valid(old));
+    refpool_destroy(p);
+}
+TEST_CASE("refpool created from several threads", "[managed_reference_pool]")
+{
+    enum { NUM_THREADS = 8, NUM_ROUNDS = 2000, NUM_REF = 4 };
+    std::atomic_int          failures { 0 };
+    std::vector<std::thread> threads;
+
+    // Each thread must own its table entry; a shared one would resolve compact
+    // handles into another pool, or lose its views to another destroy.
+    for ( int t = 0; t < NUM_THREADS; ++t )
+    {
+        threads.emplace_back([t, &failures] {
+            for ( int r = 0; r < NUM_ROUNDS; ++r )
+            {
+                auto          p = refpool_create(NUM_REF);
+                refhandle64_t hd[NUM_REF];
+                for ( int i = 0; i < NUM_REF; ++i )
+                {
+                    auto h = refpool_malloc(p, sizeof(int));
+                    *(int*) ref_lock(&h) = t * NUM_REF + i;
+                    ref_unlock(&h);
+                    hd[i] = ref_compact(&h);
+                }
+                for ( int i = 0; i < NUM_REF; ++i )
+                {
+                    auto obj = (int*) ref64_lock(hd[i]);
+                    failures += obj == nullptr || *obj != t * NUM_REF + i;
+                    if ( obj )
+                        ref64_unlock(hd[i]);
+                }
+                refpool_destroy(p);
+            }
+        });
+    }
+    for ( auto& th : threads )
+        th.join();
+
+    REQUIRE(failures == 0);
+}
+
+TEST_CASE("refpool growth", "[managed_reference_pool]")
+{
+    enum { CHUNK = 8, MAX_CHUNKS = 4 };
+    auto p = refpool_create_growable(CHUNK, MAX_CHUNKS, nullptr, nullptr, 0);
+    REQUIRE(refpool_num_available(p) == CHUNK * MAX_CHUNKS);
+
+    std::vector<refhandle_t>   hd;
+    std::vector<refhandle64_t> hc;
+    for ( int i = 0; i < CHUNK * 3; ++i )
+    {
+        hd.push_back(refpool_malloc(p, sizeof(int)));
+        *(int*) ref_lock(&hd.back()) = i;
+        ref_unlock(&hd.back());
+        hc.push_back(ref_compact(&hd.back()));
+    }
+    REQUIRE(hd.back().chunk == 2);
+    REQUIRE(refpool_num_available(p) == CHUNK);
+
+    // Handles stay valid across growth.
+    for ( int i = 0; i < CHUNK * 3; ++i )
+    {
+        REQUIRE(*(int*) ref_lock(&hd[i]) == i);
+        ref_unlock(&hd[i]);
+        REQUIRE(*(int*) ref64_lock(hc[i]) == i);
+        ref64_unlock(hc[i]);
+    }
+
+    int count = 0;
+    refpool_foreach(p, &count, [] (void* c, auto) { ++*(int*) c; });
+    REQUIRE(count == CHUNK * 3);
+
+    // Only trailing empty chunks are released.
+    ref_free(&hd[CHUNK]);
+    for ( int i = CHUNK * 2; i < CHUNK * 3; ++i )
+        ref_free(&hd[i]);
+    REQUIRE(refpool_shrink(p) == 1);
+    REQUIRE(refpool_shrink(p) == 0);
+    REQUIRE(refpool_num_available(p) == CHUNK * 2 + 1);
+
+    // Grow again; handles into released chunk never revive.
+    for ( int i = 0; i < CHUNK * 2 + 1; ++i )
+        refpool_malloc(p, sizeof(int));
+    for ( int i = CHUNK * 2; i < CHUNK * 3; ++i )
+    {
+        REQUIRE_FALSE(ref_is_valid(&hd[i]));
+        REQUIRE_FALSE(ref64_is_valid(hc[i]));
+    }
+    REQUIRE(ref_is_valid(&hd[CHUNK + 1]));
+    REQUIRE_FALSE(ref64_is_valid(hc[CHUNK]));
+
+    refpool_destroy(p);
+}
+TEST_CASE("refpool allocation failure", "[managed_reference_pool]")
+{
+    struct counter
+    {
+        allocator_t a;
+        int         live = 0;
+        bool        fail = false;
+    } al;
+    al.a.object   = &al;
+    al.a.allocate = [] (void* c, size_t sz) -> void* {
+        auto cnt = (counter*) c;
+        if ( cnt->fail )
+            return nullptr;
+        ++cnt->live;
+        return malloc(sz);
+    };
+    al.a.release = [] (void* c, void* mem) {
+        --( (counter*) c )->live;
+        free(mem);
+    };
+
+    enum { CHUNK = 4 };
+    auto p = refpool_create_growable(CHUNK, 2, &al.a, nullptr, 0);
+
+    std::vector<refhandle_t> hd;
+    for ( int i = 0; i < CHUNK; ++i )
+        hd.push_back(refpool_malloc(p, sizeof(int)));
+    REQUIRE(al.live == CHUNK);
+
+    // Neither chunk nor object can be allocated.
+    al.fail = true;
+    auto h  = refpool_malloc(p, sizeof(int));
+    REQUIRE(h.id == OBJECTID_NULL);
+    REQUIRE_FALSE(ref_is_valid(&h));
+    REQUIRE(refpool_num_available(p) == CHUNK);
+
+    // Second chunk comes from the allocator, but object doesn't.
+    al.fail = false;
+    hd.push_back(refpool_malloc(p, sizeof(int)));
+    REQUIRE(hd.back().chunk == 1);
+    REQUIRE(al.live == CHUNK + 2);
+    al.fail = true;
+    h       = refpool_malloc(p, sizeof(int));
+    REQUIRE(h.id == OBJECTID_NULL);
+    REQUIRE(refpool_num_available(p) == CHUNK - 1);
+
+    // Pool can't grow beyond maxChunks.
+    al.fail = false;
+    for ( int i = 1; i < CHUNK; ++i )
+        hd.push_back(refpool_malloc(p, sizeof(int)));
+    REQUIRE(refpool_num_available(p) == 0);
+    h = refpool_malloc(p, sizeof(int));
+    REQUIRE(h.id == OBJECTID_NULL);
+    REQUIRE_FALSE(ref_is_valid(&h));
+
+    for ( auto& e : hd )
+        REQUIRE(ref_is_valid(&e));
+
+    refpool_destroy(p);
+    REQUIRE(al.live == 0);
+}
+TEST_CASE("refpool handle check benchmark",
+          "[managed_reference_pool][.benchmark]")
+{
+    using clock = std::chrono::steady_clock;
+    enum { NUM_REF = 60000, NUM_ROUNDS = 100 };
+    auto p = refpool_create(NUM_REF);
+
+    std::vector<refhandle_t>   hd(NUM_REF);
+    std::vector<refhandle64_t> hc(NUM_REF);
+    for ( int i = 0; i < NUM_REF; ++i )
+    {
+        hd[i] = refpool_malloc(p, sizeof(int));
+        hc[i] = ref_compact(&hd[i]);
+    }
+
+    size_t valid = 0;
+    auto   t0    = clock::now();
+    for ( int r = 0; r < NUM_ROUNDS; ++r )
+        for ( auto& h : hd )
+            valid += ref_is_valid(&h);
+    auto t1 = clock::now();
+    for ( int r = 0; r < NUM_ROUNDS; ++r )
+        for ( auto h : hc )
+            valid += ref64_is_valid(h);
+    auto t2 = clock::now();
+
+    REQUIRE(valid == 2u * NUM_REF * NUM_ROUNDS);
+    auto ns = [] (clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count()
+               / ( NUM_REF * NUM_ROUNDS );
+    };
+    WARN("refhandle_t   " << ns(t1 - t0) << "ns/check");
+    WARN("refhandle64_t " << ns(t2 - t1) << "ns/check");
+
+    refpool_destroy(p);
+}
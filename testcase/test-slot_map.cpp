@@ -0,0 +1,162 @@
+#include <Catch2/catch.hpp>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <uEmbedded-pp/slot_map.hxx>
+
+TEST_CASE( "Generational slot map", "[slot_map]" )
+{
+    upp::slot_map<std::string, uint16_t> m( 100 );
+    static_assert( sizeof( decltype( m )::handle_type ) == 4 );
+    REQUIRE( m.capacity() == 100 );
+
+    std::vector<uint32_t> handles;
+    for ( int i = 0; i < 100; ++i )
+        handles.push_back( m.emplace( std::to_string( i ) ) );
+    REQUIRE( m.full() );
+    REQUIRE( m.insert( "overflow" ) == m.HANDLE_NONE );
+    REQUIRE_FALSE( m.contains( m.HANDLE_NONE ) );
+
+    for ( int i = 0; i < 100; ++i )
+        REQUIRE( m[handles[i]] == std::to_string( i ) );
+
+    SECTION( "Erase keeps values dense" )
+    {
+        for ( int i = 0; i < 100; i += 2 )
+            REQUIRE( m.erase( handles[i] ) );
+        REQUIRE( m.size() == 50 );
+        REQUIRE( m.end() - m.begin() == 50 );
+
+        std::set<std::string> left( m.begin(), m.end() );
+        for ( int i = 0; i < 100; ++i ) {
+            REQUIRE( m.contains( handles[i] ) == ( i % 2 == 1 ) );
+            REQUIRE( left.count( std::to_string( i ) ) == size_t( i % 2 ) );
+            if ( i % 2 )
+                REQUIRE( *m.find( handles[i] ) == std::to_string( i ) );
+            else
+                REQUIRE( m.find( handles[i] ) == nullptr );
+        }
+
+        for ( auto it = m.begin(); it != m.end(); ++it )
+            REQUIRE( &m[m.handle_of( it )] == it );
+    }
+
+    SECTION( "Stale handle doesn't match reused slot" )
+    {
+        auto h = handles[42];
+        REQUIRE( m.erase( h ) );
+        REQUIRE_FALSE( m.erase( h ) );
+
+        auto h2 = m.insert( "reused" );
+        REQUIRE( m.index_of( h2 ) == m.index_of( h ) );
+        REQUIRE( m.generation_of( h2 ) != m.generation_of( h ) );
+        REQUIRE_FALSE( m.contains( h ) );
+        REQUIRE( m[h2] == "reused" );
+    }
+
+    SECTION( "Erase by iterator and clear" )
+    {
+        auto it = m.erase( m.begin() );
+        REQUIRE( *it == "99" );
+        REQUIRE_FALSE( m.contains( handles[0] ) );
+        REQUIRE( m[handles[99]] == "99" );
+
+        m.clear();
+        REQUIRE( m.empty() );
+        for ( auto h : handles )
+            REQUIRE_FALSE( m.contains( h ) );
+    }
+}
+
+TEST_CASE( "Slot map rejects forged handles", "[slot_map]" )
+{
+    upp::slot_map<int, uint16_t> m( 8 );
+    auto                         forge = []( uint32_t slot, uint32_t gen ) {
+        return gen << 16 | slot;
+    };
+
+    auto h = m.emplace( 1 );
+    REQUIRE( m.index_of( h ) == 0 );
+
+    // Never used slots, and generation 0 of the live one.
+    for ( uint32_t f : { uint32_t( m.HANDLE_NONE ), 1u, 7u, forge( 0, 0 ) } ) {
+        REQUIRE_FALSE( m.contains( f ) );
+        REQUIRE( m.find( f ) == nullptr );
+        REQUIRE_FALSE( m.erase( f ) );
+    }
+
+    // Free slot doesn't match its next generation either.
+    auto g = m.emplace( 2 );
+    REQUIRE( m.erase( g ) );
+    auto next = forge( m.index_of( g ), m.generation_of( g ) + 1 );
+    REQUIRE_FALSE( m.contains( next ) );
+    REQUIRE_FALSE( m.erase( next ) );
+
+    REQUIRE( m.size() == 1 );
+    REQUIRE( m[h] == 1 );
+
+    // Generation wraps around from the odd maximum to 0, which is free.
+    upp::slot_map<int, uint8_t> n( 1 );
+    auto                        first = n.emplace( 0 );
+    n.erase( first );
+    for ( int i = 0; i < 1000; ++i ) {
+        auto k = n.emplace( i );
+        REQUIRE( n.contains( k ) );
+        REQUIRE( n.erase( k ) );
+        REQUIRE_FALSE( n.contains( k ) );
+        REQUIRE( n.empty() );
+    }
+}
+
+TEST_CASE( "Slot map with move-only values", "[slot_map]" )
+{
+    upp::slot_map<std::unique_ptr<int>> m( 8 );
+    static_assert( sizeof( decltype( m )::handle_type ) == 8 );
+
+    auto a = m.emplace( std::make_unique<int>( 1 ) );
+    auto b = m.emplace( std::make_unique<int>( 2 ) );
+    auto c = m.emplace( std::make_unique<int>( 3 ) );
+
+    m.erase( a );
+    REQUIRE( *m[c] == 3 );
+    REQUIRE( *m.begin()[0] == 3 );
+    REQUIRE( *m[b] == 2 );
+
+    // Generations survive many reuses of single slot.
+    for ( int i = 0; i < 1000; ++i ) {
+        auto h = m.emplace( std::make_unique<int>( i ) );
+        REQUIRE( *m[h] == i );
+        REQUIRE( m.erase( h ) );
+        REQUIRE_FALSE( m.contains( h ) );
+    }
+    REQUIRE( m.size() == 2 );
+}
+
+TEST_CASE( "Slot map with throwing constructor", "[slot_map]" )
+{
+    struct thrower
+    {
+        explicit thrower( int v )
+            : v( v )
+        {
+            if ( v < 0 )
+                throw v;
+        }
+        int v;
+    };
+
+    upp::slot_map<thrower, uint16_t> m( 2 );
+
+    // Failed emplace leaves neither value nor slot behind.
+    for ( int i = 0; i < 10; ++i )
+        REQUIRE_THROWS( m.emplace( -1 ) );
+    REQUIRE( m.empty() );
+
+    auto a = m.emplace( 1 );
+    auto b = m.emplace( 2 );
+    REQUIRE( m.full() );
+    REQUIRE( m[a].v == 1 );
+    REQUIRE( m[b].v == 2 );
+}
@@ -0,0 +1,96 @@
+#include <Catch2/catch.hpp>
+#include <map>
+#include <random>
+#include <string>
+
+#include <uEmbedded-pp/static_hash_map.hxx>
+
+TEST_CASE( "Static hash map", "[hash_map]" )
+{
+    static upp::static_hash_map<uint32_t, int, 1000> m;
+    static_assert( m.TABLE_SIZE == 2048 );
+    m.clear();
+
+    SECTION( "Insert, find and erase against reference map" )
+    {
+        std::map<uint32_t, int> ref;
+        std::mt19937            mt( 42 );
+
+        for ( int i = 0; i < 200000; ++i ) {
+            uint32_t k = mt() % 3000;
+            switch ( mt() % 3 ) {
+                case 0: {
+                    auto r = m.try_emplace( k, i );
+                    if ( ref.count( k ) ) {
+                        REQUIRE_FALSE( r.second );
+                        REQUIRE( *r.first == ref[k] );
+                    }
+                    else if ( ref.size() < m.capacity() ) {
+                        REQUIRE( r.second );
+                        ref[k] = i;
+                    }
+                    else {
+                        REQUIRE( r.first == nullptr );
+                    }
+                } break;
+
+                case 1:
+                    REQUIRE( m.erase( k ) == ( ref.erase( k ) == 1 ) );
+                    break;
+
+                case 2: {
+                    auto v = m.find( k );
+                    REQUIRE( ( v != nullptr ) == ( ref.count( k ) == 1 ) );
+                    if ( v )
+                        REQUIRE( *v == ref[k] );
+                } break;
+            }
+            REQUIRE( m.size() == ref.size() );
+
+            // Nothing is purged implicitly.
+            if ( m.tombstones() >= m.TABLE_SIZE / 16 ) {
+                auto num_before = m.size();
+                m.purge();
+                REQUIRE( m.tombstones() == 0 );
+                REQUIRE( m.size() == num_before );
+            }
+        }
+
+        size_t cnt = 0;
+        m.for_each( [&]( uint32_t k, int v ) {
+            REQUIRE( ref.at( k ) == v );
+            ++cnt;
+        } );
+        REQUIRE( cnt == ref.size() );
+    }
+
+    SECTION( "Fill up to capacity" )
+    {
+        for ( uint32_t i = 0; i < 1000; ++i )
+            REQUIRE( m.try_emplace( i * 7919, int( i ) ).second );
+        REQUIRE( m.full() );
+        REQUIRE( m.try_emplace( 1, 1 ).first == nullptr );
+        for ( uint32_t i = 0; i < 1000; ++i )
+            REQUIRE( *m.find( i * 7919 ) == int( i ) );
+    }
+}
+
+TEST_CASE( "Static hash map with string keys", "[hash_map]" )
+{
+    upp::static_hash_map<std::string, std::string, 64> m;
+
+    REQUIRE( m.insert_or_assign( "alpha", "1" ) );
+    REQUIRE( m.insert_or_assign( "beta", "2" ) );
+    REQUIRE( *m.insert_or_assign( "alpha", "3" ) == "3" );
+    REQUIRE( m.size() == 2 );
+
+    // Heterogeneous lookup doesn't construct std::string.
+    REQUIRE( *m.find( std::string_view( "beta" ) ) == "2" );
+    REQUIRE( m.contains( std::string( "alpha" ) ) );
+    REQUIRE_FALSE( m.contains( std::string( "gamma" ) ) );
+
+    REQUIRE( m.erase( std::string( "alpha" ) ) );
+    REQUIRE( m.size() == 1 );
+    REQUIRE( upp::hash::fnv1a_64_bytes( "abc", 3 )
+             == upp::hash::fnv1a_64( "abc" ) );
+}
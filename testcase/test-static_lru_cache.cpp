@@ -0,0 +1,120 @@
+#include <Catch2/catch.hpp>
+#include <list>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include <uEmbedded-pp/static_lru_cache.hxx>
+
+TEST_CASE( "Static LRU cache", "[lru_cache]" )
+{
+    upp::static_lru_cache<int, std::string, 3> c;
+
+    c.put( 1, "one" );
+    c.put( 2, "two" );
+    c.put( 3, "three" );
+    REQUIRE( c.size() == 3 );
+
+    // 1 becomes the most recent, thus 2 is evicted next.
+    REQUIRE( *c.get( 1 ) == "one" );
+    c.put( 4, "four" );
+    REQUIRE( c.get( 2 ) == nullptr );
+    REQUIRE( c.stats().evictions == 1 );
+
+    // Overwrite doesn't evict.
+    c.put( 3, "THREE" );
+    REQUIRE( c.stats().evictions == 1 );
+    REQUIRE( *c.peek( 3 ) == "THREE" );
+
+    int order[3], n = 0;
+    for ( auto& e : c )
+        order[n++] = e.key;
+    REQUIRE( order[0] == 3 );
+    REQUIRE( order[1] == 4 );
+    REQUIRE( order[2] == 1 );
+
+    REQUIRE( c.stats().hits == 1 );
+    REQUIRE( c.stats().misses == 1 );
+
+    REQUIRE( c.erase( 4 ) );
+    REQUIRE_FALSE( c.erase( 4 ) );
+    c.put( 5, "five" );
+    c.put( 6, "six" );
+    REQUIRE( c.peek( 1 ) == nullptr );
+    REQUIRE( c.stats().evictions == 2 );
+}
+
+TEST_CASE( "Static LRU cache against reference model", "[lru_cache]" )
+{
+    enum
+    {
+        CAP = 500
+    };
+    static upp::static_lru_cache<uint32_t, uint32_t, CAP> c;
+
+    // Reference model: list in recency order and its index.
+    std::list<std::pair<uint32_t, uint32_t>> ref;
+    std::unordered_map<uint32_t, decltype( ref )::iterator> idx;
+    size_t evictions = 0, hits = 0, misses = 0;
+
+    std::mt19937 mt( 7 );
+    for ( uint32_t i = 0; i < 300000; ++i ) {
+        uint32_t k = mt() % 1500;
+        if ( mt() % 2 ) {
+            auto v = c.get( k );
+            auto r = idx.find( k );
+            REQUIRE( ( v != nullptr ) == ( r != idx.end() ) );
+            if ( v ) {
+                ++hits;
+                REQUIRE( *v == r->second->second );
+                ref.splice( ref.begin(), ref, r->second );
+            }
+            else {
+                ++misses;
+            }
+        }
+        else {
+            c.put( k, i );
+            auto r = idx.find( k );
+            if ( r != idx.end() ) {
+                r->second->second = i;
+                ref.splice( ref.begin(), ref, r->second );
+            }
+            else {
+                if ( ref.size() == CAP ) {
+                    idx.erase( ref.back().first );
+                    ref.pop_back();
+                    ++evictions;
+                }
+                ref.emplace_front( k, i );
+                idx[k] = ref.begin();
+            }
+        }
+
+        if ( i % 10000 == 0 ) {
+            c.purge();
+            REQUIRE( c.tombstones() == 0 );
+        }
+    }
+
+    REQUIRE( c.size() == ref.size() );
+    REQUIRE( c.stats().hits == hits );
+    REQUIRE( c.stats().misses == misses );
+    REQUIRE( c.stats().evictions == evictions );
+
+    auto it = ref.begin();
+    for ( auto& e : c ) {
+        REQUIRE( e.key == it->first );
+        REQUIRE( e.value == it->second );
+        ++it;
+    }
+
+    // Same order through const reference.
+    auto const& cc = c;
+    it             = ref.begin();
+    for ( auto& e : cc ) {
+        REQUIRE( e.key == it->first );
+        ++it;
+    }
+    REQUIRE( it == ref.end() );
+}
@@ -0,0 +1,102 @@
+#ifdef __linux__
+#    include <Catch2/catch.hpp>
+#    include <sys/epoll.h>
+#    include <uEmbedded-pp/timer_fd.hxx>
+#    include <uEmbedded-pp/timer_logic.hxx>
+#    include <vector>
+extern "C" {
+#    include <uEmbedded/timer_fd.h>
+}
+
+namespace {
+//! Wait for fd readable, in milliseconds. Returns false on timeout.
+bool wait_readable( int ep, int timeout )
+{
+    epoll_event ev;
+    return epoll_wait( ep, &ev, 1, timeout ) == 1;
+}
+} // namespace
+
+TEST_CASE( "Timerfd driver", "[timer-fd]" )
+{
+    int         ep = epoll_create1( 0 );
+    epoll_event ev = {};
+    ev.events      = EPOLLIN;
+    REQUIRE( ep >= 0 );
+
+    SECTION( "C timer logic" )
+    {
+        timer_logic       s;
+        timer_fd_t        d;
+        std::vector<char> buff( 8 * TIMER_ELEM_SIZE );
+        int               fired = 0;
+        auto cb = []( void* o ) { ++*(int*)o; };
+
+        timer_init( &s, buff.data(), buff.size() );
+        REQUIRE( timer_fd_init( &d, 1000000 ) );
+        REQUIRE( epoll_ctl( ep, EPOLL_CTL_ADD, d.fd, &ev ) == 0 );
+
+        // Nothing armed, thus nothing to wake up.
+        REQUIRE( timer_fd_sync( &d, &s ) );
+        REQUIRE( d.armed == (size_t)-1 );
+        REQUIRE_FALSE( wait_readable( ep, 10 ) );
+
+        size_t now = timer_fd_now( &d );
+        timer_add( &s, now + 20, cb, &fired );
+        REQUIRE( timer_fd_sync( &d, &s ) );
+        REQUIRE( d.armed == now + 20 );
+
+        // Later timer doesn't change the deadline.
+        timer_add( &s, now + 40, cb, &fired );
+        REQUIRE( timer_fd_sync( &d, &s ) );
+        REQUIRE( d.armed == now + 20 );
+
+        REQUIRE( wait_readable( ep, 1000 ) );
+        size_t next;
+        REQUIRE( timer_fd_dispatch( &d, &s, &next ) );
+        REQUIRE( next == now + 40 );
+        REQUIRE( fired == 1 );
+        REQUIRE( timer_fd_now( &d ) >= now + 20 );
+        REQUIRE( d.armed == now + 40 );
+
+        REQUIRE( wait_readable( ep, 1000 ) );
+        REQUIRE( timer_fd_dispatch( &d, &s, &next ) );
+        REQUIRE( next == (size_t)-1 );
+        REQUIRE( fired == 2 );
+        REQUIRE_FALSE( wait_readable( ep, 10 ) );
+
+        // Arming closed fd fails, and keeps the armed deadline.
+        timer_fd_destroy( &d );
+        REQUIRE_FALSE( timer_fd_arm( &d, now + 100 ) );
+        REQUIRE( d.armed == (size_t)-1 );
+    }
+
+    SECTION( "C++ timer logic" )
+    {
+        using logic_t = upp::static_timer_logic<
+          int64_t,
+          uint16_t,
+          8,
+          upp::monotonic_tick<std::chrono::milliseconds>>;
+        logic_t              tim;
+        upp::timer_fd_driver drv( tim );
+        int                  fired = 0;
+        auto cb = []( void* o ) { ++*(int*)o; };
+
+        REQUIRE( drv.valid() );
+        REQUIRE( epoll_ctl( ep, EPOLL_CTL_ADD, drv.fd(), &ev ) == 0 );
+
+        tim.add( 20, &fired, cb );
+        REQUIRE( drv.sync() );
+
+        REQUIRE( wait_readable( ep, 1000 ) );
+        logic_t::tick_type next;
+        REQUIRE( drv.dispatch( &next ) );
+        REQUIRE( next == upp::TIMER_INVALID );
+        REQUIRE( fired == 1 );
+        REQUIRE_FALSE( wait_readable( ep, 10 ) );
+    }
+
+    close( ep );
+}
+#endif
@@ -3,7 +3,9 @@ extern "C" {
 #include <uEmbedded/timer_logic.h>
 }
 
+#include <chrono>
 #include <list>
+#include <vector>
 #include <uEmbedded-pp/timer_logic.hxx>
 
 TEST_CASE( "Timer logic functionality test", "[timer-logic]" )
@@ -64,6 +66,92 @@ TEST_CASE( "Timer logic functionality test", "[timer-logic]" )
     }
 }
 
+TEST_CASE( "Timer wheel ordering", "[timer-logic]" )
+{
+    timer_logic s;
+    enum
+    {
+        NUM_TIMER = 5000
+    };
+    std::vector<char>           buff( NUM_TIMER * TIMER_ELEM_SIZE );
+    std::vector<timer_handle_t> h( NUM_TIMER );
+    std::vector<size_t>         fired;
+
+    REQUIRE( timer_init( &s, buff.data(), buff.size() ) == NUM_TIMER );
+    REQUIRE( timer_nextTrigger( &s ) == (size_t)-1 );
+
+    struct arg_t
+    {
+        std::vector<size_t>* fired;
+        size_t               when;
+        size_t               order;
+    };
+    std::vector<arg_t> args( NUM_TIMER );
+
+    // Many timers share trigger time, and are spread over multiple levels.
+    for ( size_t i = 0; i < NUM_TIMER; ++i ) {
+        args[i] = { &fired, ( (size_t)rand() % 64 ) << ( rand() % 24 ), i };
+        h[i]    = timer_add(
+          &s,
+          args[i].when,
+          []( void* o ) {
+              auto a = (arg_t*)o;
+              a->fired->push_back( a->order );
+          },
+          &args[i] );
+    }
+
+    // Erase some of them
+    size_t numErased = 0;
+    for ( size_t i = 0; i < NUM_TIMER; i += 7, ++numErased ) {
+        REQUIRE( timer_erase( &s, h[i] ) );
+        REQUIRE_FALSE( timer_erase( &s, h[i] ) );
+    }
+
+    size_t now = 0;
+    while ( s.nodes.size ) {
+        auto next = timer_nextTrigger( &s );
+        REQUIRE( next >= now );
+        now        = next + rand() % 1000;
+        auto first = fired.size();
+        timer_update( &s, now );
+        REQUIRE( fired.size() > first );
+    }
+
+    REQUIRE( fired.size() == NUM_TIMER - numErased );
+    for ( size_t i = 1; i < fired.size(); ++i ) {
+        auto& a = args[fired[i - 1]];
+        auto& b = args[fired[i]];
+        REQUIRE(
+          ( a.when < b.when || ( a.when == b.when && a.order < b.order ) ) );
+    }
+
+    SECTION( "Timers added from callback" )
+    {
+        size_t cnt = 0;
+        struct ctx_t
+        {
+            timer_logic* s;
+            size_t*      cnt;
+        } ctx { &s, &cnt };
+
+        timer_add(
+          &s,
+          now + 10,
+          []( void* o ) {
+              auto c = (ctx_t*)o;
+              ++*c->cnt;
+              // Past time timer fires in the same update.
+              timer_add(
+                c->s, 0, []( void* o ) { ++*( (ctx_t*)o )->cnt; }, o );
+          },
+          &ctx );
+
+        REQUIRE( timer_update( &s, now + 10 ) == (size_t)-1 );
+        REQUIRE( cnt == 2 );
+    }
+}
+
 TEST_CASE( "Timer logic cpp version test", "[timer-logic]" )
 {
     upp::static_timer_logic<uint64_t, size_t, 100> tim;
@@ -84,4 +172,413 @@ TEST_CASE( "Timer logic cpp version test", "[timer-logic]" )
         ++ticks;
         REQUIRE_NOTHROW( tim.update() );
     }
-}
\ No newline at end of file
+}
+TEST_CASE( "Timer logic heap container test", "[timer-logic]" )
+{
+    upp::static_heap_timer_logic<uint64_t, uint16_t, 1000> tim;
+    using desc_t = decltype( tim )::desc_type;
+
+    uint64_t ticks = 0;
+    tim.tick_function( [&ticks]() { return ticks; } );
+
+    struct arg_t
+    {
+        std::vector<desc_t>* fired;
+        desc_t               desc;
+    };
+    std::vector<desc_t> fired;
+    std::vector<arg_t>  args( tim.capacity() );
+
+    std::vector<decltype( tim )::handle_type> handles;
+    for ( auto& a : args ) {
+        a.fired = &fired;
+        handles.push_back( tim.add( rand() % 1000, &a, []( void* o ) {
+            auto a = (arg_t*)o;
+            a->fired->push_back( a->desc );
+        } ) );
+        REQUIRE( tim.browse( handles.back(), a.desc ) );
+    }
+    REQUIRE( tim.capacity() == 0 );
+
+    for ( size_t i = 0; i < handles.size(); i += 3 ) {
+        REQUIRE( tim.remove( handles[i] ) );
+        REQUIRE_FALSE( tim.remove( handles[i] ) );
+    }
+
+    // Released slot must not be resolved by stale handle after reuse.
+    auto h = tim.add( 0, &args[0], []( void* ) {} );
+    REQUIRE( h.slot_ == handles[999].slot_ );
+    REQUIRE_FALSE( tim.remove( handles[999] ) );
+    REQUIRE( tim.remove( h ) );
+
+    while ( ticks < 1000 ) {
+        tim.update();
+        ++ticks;
+    }
+
+    REQUIRE( tim.empty() );
+    REQUIRE( fired.size() == handles.size() - ( handles.size() + 2 ) / 3 );
+    for ( size_t i = 1; i < fired.size(); ++i ) {
+        auto& a = fired[i - 1];
+        auto& b = fired[i];
+        REQUIRE( ( a.trigger_at_ < b.trigger_at_
+                   || ( a.trigger_at_ == b.trigger_at_ && a.id_ < b.id_ ) ) );
+    }
+}
+
+TEST_CASE( "Timer logic batched update", "[timer-logic]" )
+{
+    using timer_t = upp::static_heap_timer_logic<uint64_t, uint16_t, 5000>;
+    timer_t tim;
+
+    uint64_t ticks = 0;
+    tim.tick_function( [&ticks]() { return ticks; } );
+
+    struct ctx_t
+    {
+        timer_t* tim;
+        size_t           fired;
+    } ctx { &tim, 0 };
+
+    for ( size_t i = 0; i < 4000; ++i ) {
+        tim.add( 10, &ctx, []( void* o ) { ++( (ctx_t*)o )->fired; } );
+    }
+
+    // Re-entrant timer which is due immediately
+    tim.add( 10, &ctx, []( void* o ) {
+        auto c = (ctx_t*)o;
+        c->tim->add( 0, c, []( void* o ) { ++( (ctx_t*)o )->fired; } );
+    } );
+
+    size_t num_lock = 0, num_unlock = 0;
+    auto   lock     = [&] { ++num_lock; };
+    auto   unlock   = [&] { ++num_unlock; };
+
+    REQUIRE( tim.update_batch_lock( lock, unlock ) == tim.next_trig() );
+    REQUIRE( ctx.fired == 0 );
+    REQUIRE( num_lock == 1 );
+
+    timer_t::desc_type scratch[1024];
+    ticks    = 10;
+    num_lock = num_unlock = 0;
+    tim.update_batch_lock( lock, unlock, scratch, 1024 );
+
+    REQUIRE( ctx.fired == 4001 );
+    REQUIRE( tim.empty() );
+    REQUIRE( num_lock == num_unlock );
+    REQUIRE( num_lock <= 4001 / 1024 + 3 );
+}
+
+TEST_CASE( "Timer logic batched update samples tick once", "[timer-logic]" )
+{
+    using timer_t = upp::static_heap_timer_logic<uint64_t, uint16_t, 16>;
+    timer_t tim;
+
+    uint64_t ticks = 0;
+    tim.tick_function( [&ticks]() { return ticks; } );
+
+    struct ctx_t
+    {
+        timer_t*  tim;
+        uint64_t* ticks;
+        size_t    fired;
+    } ctx { &tim, &ticks, 0 };
+
+    // Clock advances while the callback runs, then the timer re-arms itself.
+    // Re-sampling the tick every pass would keep firing it forever.
+    static upp::timer_cb_t rearm = []( void* o ) {
+        auto c = (ctx_t*)o;
+        ++c->fired;
+        ++*c->ticks;
+        c->tim->add( 0, c, rearm );
+    };
+    tim.add( 0, &ctx, rearm );
+
+    timer_t::desc_type scratch[4];
+    for ( size_t i = 1; i <= 3; ++i ) {
+        tim.update_batch_lock( [] {}, [] {}, scratch, 4 );
+        REQUIRE( ctx.fired == i );
+        REQUIRE( tim.size() == 1 );
+    }
+}
+
+namespace {
+uint64_t g_ticks = 0;
+
+struct global_tick
+{
+    uint64_t operator()() const noexcept { return g_ticks; }
+};
+} // namespace
+
+TEST_CASE( "Timer logic with functor tick source", "[timer-logic]" )
+{
+    upp::static_heap_timer_logic<uint64_t, uint16_t, 100, global_tick> tim;
+
+    uint64_t cnt = 0;
+    g_ticks      = 0;
+    for ( int i = 0; i < 100; ++i )
+        tim.add( i, &cnt, []( void* o ) { ++*(uint64_t*)o; } );
+
+    for ( ; g_ticks < 100; ++g_ticks ) {
+        tim.update();
+        REQUIRE( cnt == g_ticks + 1 );
+    }
+
+    upp::static_timer_logic<
+      int64_t,
+      uint16_t,
+      10,
+      upp::clock_tick<std::chrono::steady_clock, std::chrono::hours>>
+      clk;
+    clk.add( 1, &cnt, []( void* o ) { ++*(uint64_t*)o; } );
+    REQUIRE( clk.update() == clk.next_trig() );
+    REQUIRE( clk.size() == 1 );
+}
+
+template <typename timer_t>
+static void bench_update( char const* name, timer_t& tim )
+{
+    using clock = std::chrono::steady_clock;
+    int cnt     = 0;
+
+    // Pending timers which never become due during the benchmark.
+    for ( int i = 0; i < 100; ++i )
+        tim.add( 1ull << 40, &cnt, []( void* ) {} );
+
+    for ( size_t num_due : { 0, 1, 1000 } ) {
+        enum
+        {
+            NUM_ROUND = 10000
+        };
+        clock::duration elapsed {};
+
+        for ( size_t r = 0; r < NUM_ROUND; ++r ) {
+            for ( size_t i = 0; i < num_due; ++i )
+                tim.add( 0, &cnt, []( void* o ) { ++*(int*)o; } );
+
+            auto t0 = clock::now();
+            tim.update();
+            elapsed += clock::now() - t0;
+        }
+
+        WARN(
+          name << ", " << num_due << " due timers: "
+               << std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    elapsed )
+                      .count()
+                    / NUM_ROUND
+               << "ns per update" );
+    }
+}
+
+TEST_CASE( "Timer logic update benchmark", "[timer-logic][.benchmark]" )
+{
+    g_ticks = 0;
+    {
+        upp::static_heap_timer_logic<uint64_t, uint16_t, 1200> tim;
+        tim.tick_function( [] { return g_ticks; } );
+        bench_update( "std::function", tim );
+    }
+    {
+        upp::static_heap_timer_logic<uint64_t, uint16_t, 1200, global_tick> tim;
+        bench_update( "functor", tim );
+    }
+}
+
+TEST_CASE( "Timer coalescing with slack", "[timer-logic]" )
+{
+    timer_logic s;
+    enum
+    {
+        NUM_TIMER = 1000,
+        SLACK     = 500
+    };
+    std::vector<char> buff( NUM_TIMER * TIMER_ELEM_SIZE );
+    timer_init( &s, buff.data(), buff.size() );
+
+    struct arg_t
+    {
+        size_t  when;
+        size_t* now;
+        bool    inRange;
+    };
+    std::vector<arg_t> args( NUM_TIMER );
+    size_t             now = 0;
+
+    for ( auto& a : args ) {
+        a = { (size_t)rand() % 100000, &now, false };
+        timer_add_slack( &s, a.when, SLACK, []( void* o ) {
+            auto a     = (arg_t*)o;
+            a->inRange = *a->now >= a->when && *a->now <= a->when + SLACK;
+        }, &a );
+    }
+
+    // Event loop which sleeps until next trigger time.
+    size_t numWakeup = 0;
+    for ( ; ( now = timer_nextTrigger( &s ) ) != (size_t)-1; ++numWakeup )
+        timer_update( &s, now );
+
+    for ( auto& a : args )
+        REQUIRE( a.inRange );
+
+    REQUIRE( s.stats.numFired == NUM_TIMER );
+    REQUIRE( s.stats.numWakeups == numWakeup );
+    REQUIRE( timer_wakeupsSaved( &s ) == NUM_TIMER - numWakeup );
+    REQUIRE( numWakeup < NUM_TIMER / 2 );
+}
+
+TEST_CASE( "Timer slack picks the most trailing zeros", "[timer-logic]" )
+{
+    timer_logic       s;
+    std::vector<char> buff( 4 * TIMER_ELEM_SIZE );
+    timer_init( &s, buff.data(), buff.size() );
+
+    struct
+    {
+        size_t when, slack, expect;
+    } const cases[] = {
+        { 4, 3, 4 }, { 0, 5, 0 }, { 5, 3, 8 }, { 9, 0, 9 }, { 17, 20, 32 },
+    };
+
+    for ( auto& c : cases ) {
+        auto h = timer_add_slack( &s, c.when, c.slack, []( void* ) {}, NULL );
+        REQUIRE( timer_nextTrigger( &s ) == c.expect );
+        timer_erase( &s, h );
+    }
+}
+
+TEST_CASE( "Periodic timers", "[timer-logic]" )
+{
+    timer_logic s;
+    std::vector<char> buff( 16 * TIMER_ELEM_SIZE );
+    timer_init( &s, buff.data(), buff.size() );
+
+    struct ctx_t
+    {
+        timer_logic*   s;
+        timer_handle_t h;
+        size_t         cnt;
+        size_t         stopAt;
+    } ctx { &s, {}, 0, 0 };
+
+    auto cb = []( void* o ) {
+        auto c = (ctx_t*)o;
+        if ( ++c->cnt == c->stopAt )
+            timer_erase( c->s, c->h );
+    };
+
+    SECTION( "Catch up" )
+    {
+        ctx.h = timer_add_periodic( &s, 50, 100, cb, &ctx );
+
+        REQUIRE( timer_update( &s, 49 ) == 50 );
+        REQUIRE( timer_update( &s, 60 ) == 150 );
+        REQUIRE( ctx.cnt == 1 );
+
+        // Three periods at 150, 250 and 350 are missed.
+        REQUIRE( timer_update( &s, 399 ) == 450 );
+        REQUIRE( ctx.cnt == 4 );
+        REQUIRE( timer_browse( &s, ctx.h )->triggerTime == 450 );
+        REQUIRE( s.nodes.size == 1 );
+    }
+
+    SECTION( "Skip missed" )
+    {
+        s.periodicPolicy = TIMER_PERIODIC_SKIP_MISSED;
+        ctx.h            = timer_add_periodic( &s, 50, 100, cb, &ctx );
+
+        REQUIRE( timer_update( &s, 60 ) == 150 );
+        REQUIRE( timer_update( &s, 399 ) == 450 );
+        REQUIRE( ctx.cnt == 2 );
+        REQUIRE( timer_update( &s, 450 ) == 550 );
+        REQUIRE( ctx.cnt == 3 );
+    }
+
+    SECTION( "Stop from callback" )
+    {
+        ctx.stopAt = 3;
+        ctx.h      = timer_add_periodic( &s, 0, 10, cb, &ctx );
+
+        REQUIRE( timer_update( &s, 1000 ) == (size_t)-1 );
+        REQUIRE( ctx.cnt == 3 );
+        REQUIRE_FALSE( timer_isActive( &s, ctx.h ) );
+        REQUIRE( s.nodes.size == 0 );
+    }
+}
+
+TEST_CASE( "Timer compaction", "[timer-logic]" )
+{
+    timer_logic       s;
+    std::vector<char> buff( 256 * TIMER_ELEM_SIZE );
+    size_t const      cnt = timer_init( &s, buff.data(), buff.size() );
+
+    std::vector<timer_handle_t> h( cnt );
+    std::vector<size_t>         fired;
+
+    auto cb = []( void* o ) { ( (std::vector<size_t>*)o )->push_back( 0 ); };
+    for ( size_t i = 0; i < cnt; ++i )
+        h[i] = timer_add( &s, 1000 - i % 7 * 100, cb, &fired );
+    for ( size_t i = 0; i < cnt; i += 2 )
+        timer_erase( &s, h[i] );
+
+    // Timer ids equal to the index in this test.
+    timer_compact(
+      &s,
+      []( void* c, timer_handle_t const* nh ) {
+          ( *(std::vector<timer_handle_t>*)c )[nh->timerId] = *nh;
+      },
+      &h );
+
+    REQUIRE( s.nodes.hwm == s.nodes.size );
+    for ( size_t i = 1; i < cnt; i += 2 ) {
+        auto info = timer_browse( &s, h[i] );
+        REQUIRE( info );
+        REQUIRE( info->triggerTime == 1000 - i % 7 * 100 );
+    }
+
+    // Wheel is rebuilt; order of expiry is kept.
+    size_t prev = 0;
+    while ( s.nodes.size ) {
+        size_t next = timer_nextTrigger( &s );
+        REQUIRE( next >= prev );
+        prev = next;
+        timer_update( &s, next );
+    }
+    REQUIRE( fired.size() == cnt / 2 );
+}
+
+TEST_CASE( "Timer compaction keeps order of relinked timers", "[timer-logic]" )
+{
+    timer_logic       s;
+    std::vector<char> buff( 16 * TIMER_ELEM_SIZE );
+    timer_init( &s, buff.data(), buff.size() );
+
+    std::vector<int> fired;
+    struct ctx_t
+    {
+        std::vector<int>* fired;
+        int               id;
+    } p { &fired, 1 }, a { &fired, 2 };
+    auto cb = []( void* o ) {
+        auto c = (ctx_t*)o;
+        c->fired->push_back( c->id );
+    };
+
+    auto dummy = timer_add( &s, 5, cb, &p );
+    timer_add_periodic( &s, 10, 10, cb, &p );
+    timer_add( &s, 20, cb, &a );
+    timer_erase( &s, dummy );
+
+    // Periodic timer is relinked behind the one-shot timer of the same
+    // deadline, while its list position is still the first.
+    REQUIRE( timer_update( &s, 10 ) == 20 );
+    REQUIRE( fired == std::vector<int> { 1 } );
+
+    timer_compact( &s, NULL, NULL );
+    REQUIRE( s.nodes.hwm == s.nodes.size );
+
+    fired.clear();
+    REQUIRE( timer_update( &s, 20 ) == 30 );
+    REQUIRE( fired == std::vector<int> { 2, 1 } );
+}
@@ -0,0 +1,79 @@
+#include <Catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+extern "C" {
+#include <uEmbedded/timer_service.h>
+}
+
+TEST_CASE( "Sharded timer service", "[timer-service]" )
+{
+    enum
+    {
+        NUM_SHARD    = 4,
+        NUM_PRODUCER = 4,
+        NUM_EACH     = 2000,
+        NUM_TIMER    = NUM_PRODUCER * NUM_EACH
+    };
+
+    auto s = timer_service_create( NUM_SHARD, NUM_TIMER, 1024 );
+    REQUIRE( timer_service_numShards( s ) == NUM_SHARD );
+
+    std::atomic_int  fired { 0 };
+    std::atomic_int  cancelled { 0 };
+    std::atomic_int  wrongShard { 0 };
+    std::atomic_bool stop { false };
+
+    // Shard owners keep draining requests, while no timer is due yet.
+    std::vector<std::thread> owners;
+    for ( size_t i = 0; i < NUM_SHARD; ++i ) {
+        owners.emplace_back( [&, i] {
+            while ( !stop )
+                timer_service_update( s, i, 0 );
+        } );
+    }
+
+    std::vector<std::thread> producers;
+    for ( size_t p = 0; p < NUM_PRODUCER; ++p ) {
+        producers.emplace_back( [&, p] {
+            for ( size_t i = 0; i < NUM_EACH; ++i ) {
+                timer_service_handle_t h;
+                do {
+                    h = timer_service_add(
+                      s,
+                      ( p + i ) % NUM_SHARD,
+                      1000 + i,
+                      []( void* o ) { ++*(std::atomic_int*)o; },
+                      &fired );
+                } while ( h.slot == (uint32_t)TIMER_SERVICE_SLOT_NONE );
+
+                wrongShard += h.shard != ( p + i ) % NUM_SHARD;
+                if ( i % 3 == 0 ) {
+                    while ( !timer_service_cancel( s, h ) )
+                        std::this_thread::yield();
+                    ++cancelled;
+                }
+            }
+        } );
+    }
+
+    for ( auto& t : producers )
+        t.join();
+    stop = true;
+    for ( auto& t : owners )
+        t.join();
+
+    REQUIRE( fired == 0 );
+    REQUIRE( wrongShard == 0 );
+    for ( size_t i = 0; i < NUM_SHARD; ++i )
+        REQUIRE( timer_service_update( s, i, 100000 ) == (size_t)-1 );
+
+    REQUIRE( fired + cancelled == NUM_TIMER );
+
+    // Fired timer can't be cancelled.
+    auto h = timer_service_add( s, 0, 0, []( void* ) {}, NULL );
+    timer_service_update( s, 0, 0 );
+    REQUIRE_FALSE( timer_service_cancel( s, h ) );
+
+    timer_service_destroy( s );
+}